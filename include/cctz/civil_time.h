@@ -320,6 +320,28 @@ using detail::prev_weekday;
 //
 using detail::get_yearday;
 
+// Batch forms of the day arithmetic above, for callers that bucket many
+// civil times by date. For each i in [0, n), they set
+//
+//   get_weekdays():     out[i] = get_weekday(cs[i])
+//   day_differences():  out[i] = civil_day(cs[i]) - base
+//   step_days():        out[i] = cs[i] advanced by the given days
+//
+// where cs is an array of either civil_day or civil_second values. (For a
+// civil_second, step_days() keeps the time of day.) The work is done on
+// blocks of dates at once, in vector registers where available, and so is
+// much faster than a loop over the scalar forms for dates within a million
+// years or so of the present. Other dates use the scalar forms.
+//
+//   std::vector<cctz::civil_second> css = ...
+//   std::vector<cctz::diff_t> days(css.size());
+//   cctz::day_differences(css.data(), css.size(),
+//                         cctz::civil_day(1970, 1, 1), days.data());
+//
+using detail::get_weekdays;
+using detail::day_differences;
+using detail::step_days;
+
 }  // namespace cctz
 
 #endif  // CCTZ_CIVIL_TIME_H_
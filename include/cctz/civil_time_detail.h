@@ -15,6 +15,7 @@
 #ifndef CCTZ_CIVIL_TIME_DETAIL_H_
 #define CCTZ_CIVIL_TIME_DETAIL_H_
 
+#include <cstddef>
 #include <cstdint>
 #include <limits>
 #include <ostream>
@@ -98,8 +99,11 @@ CONSTEXPR_F int days_per_month(year_t y, month_t m) noexcept {
   return k_days_per_month[m] + (m == 2 && is_leap_year(y));
 }
 
-CONSTEXPR_F fields n_day(year_t y, month_t m, diff_t d, diff_t cd,
-                         hour_t hh, minute_t mm, second_t ss) noexcept {
+// Normalizes the day by stepping through 400-year, century, 4-year, year,
+// and month strides. n_day() falls back to this only for day counts so
+// large that its ordinal arithmetic might overflow.
+CONSTEXPR_F fields n_day_loop(year_t y, month_t m, diff_t d, diff_t cd,
+                              hour_t hh, minute_t mm, second_t ss) noexcept {
   year_t ey = y % 400;
   const year_t oey = ey;
   ey += (cd / 146097) * 400;
@@ -164,6 +168,51 @@ CONSTEXPR_F fields n_day(year_t y, month_t m, diff_t d, diff_t cd,
   }
   return fields(y + (ey - oey), m, static_cast<day_t>(d), hh, mm, ss);
 }
+
+// Map a (normalized) Y/M/D to the number of days before/after 1970-01-01.
+// Probably overflows for years outside [-292277022656:292277026595].
+CONSTEXPR_F diff_t ymd_ord(year_t y, month_t m, day_t d) noexcept {
+  const diff_t eyear = (m <= 2) ? y - 1 : y;
+  const diff_t era = (eyear >= 0 ? eyear : eyear - 399) / 400;
+  const diff_t yoe = eyear - era * 400;
+  const diff_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  const diff_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + doe - 719468;
+}
+
+// The inverse of ymd_ord(): map a number of days before/after 1970-01-01
+// to the fields of that date at the given time of day.
+CONSTEXPR_F fields ord_ymd(diff_t ord, hour_t hh, minute_t mm,
+                           second_t ss) noexcept {
+  const diff_t z = ord + 719468;  // days since 0000-03-01
+  const diff_t era = (z >= 0 ? z : z - 146096) / 146097;
+  const diff_t doe = z - era * 146097;  // [0:146096]
+  const diff_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  const diff_t doy = doe - (yoe * 365 + yoe / 4 - yoe / 100);  // [0:365]
+  const diff_t mp = (5 * doy + 2) / 153;  // [0:11], starting from March
+  const month_t m = static_cast<month_t>(mp < 10 ? mp + 3 : mp - 9);
+  const day_t d = static_cast<day_t>(doy - (153 * mp + 2) / 5 + 1);
+  return fields(era * 400 + yoe + (m <= 2), m, d, hh, mm, ss);
+}
+
+CONSTEXPR_F fields n_day(year_t y, month_t m, diff_t d, diff_t cd,
+                         hour_t hh, minute_t mm, second_t ss) noexcept {
+  // Given day counts that cannot overflow the ordinal, convert to and from
+  // ordinals in the year's 400-year cycle, which takes constant time.
+  const diff_t k_max_days = diff_t{1} << 61;
+  if (-k_max_days < d && d < k_max_days && -k_max_days < cd &&
+      cd < k_max_days) {
+    d += cd;
+    if (0 < d && (d <= 28 || d <= days_per_month(y, m))) {
+      return fields(y, m, static_cast<day_t>(d), hh, mm, ss);
+    }
+    const year_t ey = y % 400;
+    fields f = ord_ymd(ymd_ord(ey, m, 1) + (d - 1), hh, mm, ss);
+    f.y += y - ey;
+    return f;
+  }
+  return n_day_loop(y, m, d, cd, hh, mm, ss);
+}
 CONSTEXPR_F fields n_mon(year_t y, diff_t m, diff_t d, diff_t cd,
                          hour_t hh, minute_t mm, second_t ss) noexcept {
   if (m != 12) {
@@ -260,17 +309,6 @@ CONSTEXPR_F diff_t scale_add(diff_t v, diff_t f, diff_t a) noexcept {
   return (v < 0) ? ((v + 1) * f + a) - f : ((v - 1) * f + a) + f;
 }
 
-// Map a (normalized) Y/M/D to the number of days before/after 1970-01-01.
-// Probably overflows for years outside [-292277022656:292277026595].
-CONSTEXPR_F diff_t ymd_ord(year_t y, month_t m, day_t d) noexcept {
-  const diff_t eyear = (m <= 2) ? y - 1 : y;
-  const diff_t era = (eyear >= 0 ? eyear : eyear - 399) / 400;
-  const diff_t yoe = eyear - era * 400;
-  const diff_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
-  const diff_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
-  return era * 146097 + doe - 719468;
-}
-
 // Returns the difference in days between two normalized Y-M-D tuples.
 // ymd_ord() will encounter integer overflow given extreme year values,
 // yet the difference between two such extreme values may actually be
@@ -576,6 +614,20 @@ CONSTEXPR_F int get_yearday(const civil_second& cs) noexcept {
 
 ////////////////////////////////////////////////////////////////////////
 
+// Batch day arithmetic (see civil_time_detail.cc).
+void get_weekdays(const civil_day* cds, std::size_t n, weekday* out);
+void get_weekdays(const civil_second* css, std::size_t n, weekday* out);
+void day_differences(const civil_day* cds, std::size_t n,
+                     const civil_day& base, diff_t* out);
+void day_differences(const civil_second* css, std::size_t n,
+                     const civil_day& base, diff_t* out);
+void step_days(const civil_day* cds, std::size_t n, diff_t days,
+               civil_day* out);
+void step_days(const civil_second* css, std::size_t n, diff_t days,
+               civil_second* out);
+
+////////////////////////////////////////////////////////////////////////
+
 std::ostream& operator<<(std::ostream& os, const civil_year& y);
 std::ostream& operator<<(std::ostream& os, const civil_month& m);
 std::ostream& operator<<(std::ostream& os, const civil_day& d);
@@ -21,10 +21,12 @@
 #define CCTZ_TIME_ZONE_H_
 
 #include <chrono>
+#include <cstddef>
 #include <cstdint>
 #include <limits>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "cctz/civil_time.h"
 
@@ -94,6 +96,19 @@ class time_zone {
     return lookup(detail::split_seconds(tp).first);
   }
 
+  // Converts the n absolute times in tps[0 .. n) to civil times within
+  // this time_zone, storing the results in out[0 .. n). The results are
+  // the same as setting out[i] = lookup(tps[i]) for each i, but the batch
+  // form amortizes the per-call overhead, and it is particularly fast when
+  // the input is sorted (or nearly so), as is typical for event streams.
+  //
+  // Example:
+  //   std::vector<cctz::time_point<cctz::seconds>> tps = ...
+  //   std::vector<cctz::time_zone::absolute_lookup> als(tps.size());
+  //   tz.lookup(tps.data(), tps.size(), als.data());
+  void lookup(const time_point<seconds>* tps, std::size_t n,
+              absolute_lookup* out) const;
+
   // A civil_lookup represents the absolute time(s) (time_point) that
   // correspond to the given civil time (cctz::civil_second) within this
   // time_zone. Usually the given civil time represents a unique instant
@@ -147,6 +162,26 @@ class time_zone {
   };
   civil_lookup lookup(const civil_second& cs) const;
 
+  // Converts the n civil times in cs[0 .. n) to absolute times within this
+  // time_zone, storing the results in out[0 .. n), as if by setting out[i] =
+  // lookup(cs[i]) for each i. Like the batch absolute-time lookup above,
+  // this is fastest when the input is sorted (or nearly so).
+  //
+  // If kinds is not null, kinds[i] is also set to out[i].kind, but in a
+  // compact, one-byte form that is convenient for bulk filtering. Returns
+  // the number of results whose kind is not UNIQUE, so callers can skip
+  // looking for SKIPPED or REPEATED civil times entirely when it is zero.
+  //
+  // Example:
+  //   std::vector<cctz::civil_second> css = ...
+  //   std::vector<cctz::time_zone::civil_lookup> cls(css.size());
+  //   std::vector<std::uint_least8_t> kinds(css.size());
+  //   if (tz.lookup(css.data(), css.size(), cls.data(), kinds.data())) {
+  //     // Look for kinds[i] != cctz::time_zone::civil_lookup::UNIQUE.
+  //   }
+  std::size_t lookup(const civil_second* cs, std::size_t n, civil_lookup* out,
+                     std::uint_least8_t* kinds = nullptr) const;
+
   // Finds the time of the next/previous offset change in this time zone.
   //
   // By definition, next_transition(tp, &trans) returns false when tp has
@@ -194,6 +229,79 @@ class time_zone {
     return prev_transition(detail::split_seconds(tp).first, trans);
   }
 
+  // An offset_schedule describes the UTC offsets of a time_zone over a range
+  // of absolute times as a flat array of runs, sorted by their start. Each
+  // run holds from its start until the start of the next (or forever), and
+  // adjacent runs always differ. This lets callers convert many times (say,
+  // a column of timestamps) against the schedule themselves, with no call
+  // per time, or export the zone's rules elsewhere. Zones whose transitions
+  // cannot be enumerated (see next_transition()) have a single run, while
+  // those that observe daylight-saving time have two runs per year, so the
+  // range should be bounded accordingly. The runs from a zone's future
+  // rules stop after the (UTC) year 9999, so the final run of a schedule
+  // that reaches beyond then holds for longer than lookup() would say.
+  //
+  // Example:
+  //   const auto sched = tz.schedule(from, to);
+  //   // sched.runs[0].unix_start <= from < sched.runs[1].unix_start ...
+  struct offset_run {
+    std::int_fast64_t unix_start;   // first second (or the minimum value)
+    std::int_least32_t utc_offset;  // civil seconds east of UTC
+    bool is_dst;                    // is offset non-standard?
+    std::uint_least8_t abbr_id;     // index into offset_schedule::abbrs
+  };
+  struct offset_schedule {
+    std::vector<offset_run> runs;    // runs[0] is in effect at "from"
+    std::vector<std::string> abbrs;  // abbreviations (e.g., "PST")
+  };
+  offset_schedule schedule(const time_point<seconds>& from,
+                           const time_point<seconds>& to) const;
+
+  // A cursor converts a sequence of absolute times to civil times within
+  // a time_zone, as if by lookup(tp) on each, but it remembers the span
+  // between the transitions that surround the last time it was given. A
+  // time within that span, as is typical when the times come from a log
+  // or other stream of (mostly) increasing timestamps, is then converted
+  // inline, with no search. Crossing into the next span costs one step.
+  //
+  // A cursor is a small value type, but it is not thread safe, so each
+  // thread should use its own. The time_zone must outlive the cursor.
+  //
+  // Example:
+  //   cctz::time_zone::cursor cur(tz);
+  //   for (const auto& tp : timestamps) {
+  //     const cctz::civil_second cs = cur.lookup(tp).cs;
+  //     ...
+  //   }
+  class Impl;
+  class cursor {
+   public:
+    explicit cursor(const time_zone& tz);
+    cursor(const cursor&) = default;
+    cursor& operator=(const cursor&) = default;
+
+    absolute_lookup lookup(const time_point<seconds>& tp) {
+      if (tp < first_ || last_ < tp) seek(tp);
+      absolute_lookup al = al_;
+      al.cs += (tp - base_).count();
+      return al;
+    }
+    template <typename D>
+    absolute_lookup lookup(const time_point<D>& tp) {
+      return lookup(detail::split_seconds(tp).first);
+    }
+
+   private:
+    void seek(const time_point<seconds>& tp);
+
+    const Impl* impl_;
+    std::size_t hint_;            // the implementation's position
+    time_point<seconds> first_;   // [first_, last_] is the span of times
+    time_point<seconds> last_;    // with the offset, etc. of al_
+    time_point<seconds> base_;    // the time whose civil time is al_.cs
+    absolute_lookup al_;
+  };
+
   // version() and description() provide additional information about the
   // time zone. The content of each of the returned strings is unspecified,
   // however, when the IANA Time Zone Database is the underlying data source
@@ -212,8 +320,6 @@ class time_zone {
     return !(lhs == rhs);
   }
 
-  class Impl;
-
  private:
   explicit time_zone(const Impl* impl) : impl_(impl) {}
   const Impl& effective_impl() const;  // handles implicit UTC
@@ -262,6 +368,10 @@ namespace detail {
 using femtoseconds = std::chrono::duration<std::int_fast64_t, std::femto>;
 std::string format(const std::string&, const time_point<seconds>&,
                    const femtoseconds&, const time_zone&);
+std::size_t format(const std::string&, const time_point<seconds>&,
+                   const femtoseconds&, const time_zone&, char*, std::size_t);
+std::size_t format(const std::string&, const time_point<seconds>&,
+                   const femtoseconds&, const time_zone&, std::string*);
 bool parse(const std::string&, const std::string&, const time_zone&,
            time_point<seconds>*, femtoseconds*, std::string* err = nullptr);
 template <typename Rep, std::intmax_t Denom>
@@ -278,6 +388,20 @@ bool join_seconds(
     time_point<std::chrono::duration<Rep, std::ratio<1, 1>>>* tpp);
 bool join_seconds(const time_point<seconds>& sec, const femtoseconds&,
                   time_point<seconds>* tpp);
+
+// An operation of a cctz::format_plan (see time_zone_format.cc).
+struct format_op {
+  std::uint_least8_t kind;
+  int n;             // the precision of fractional seconds
+  std::string text;  // literal text, or a format for strftime()
+};
+
+// An operation of a cctz::parse_plan (see time_zone_format.cc).
+struct parse_op {
+  std::uint_least8_t kind;
+  int n;             // the 12/24-hour clock that a strptime() format sets
+  std::string text;  // literal text, or a format for strptime()
+};
 }  // namespace detail
 
 // Formats the given time_point in the given cctz::time_zone according to
@@ -300,6 +424,10 @@ bool join_seconds(const time_point<seconds>& sec, const femtoseconds&,
 // year. A year outside of [-999:9999] when formatted with %E4Y will produce
 // more than four characters, just like %Y.
 //
+// Note that the names produced by %a, %A, %b, %h, and %B, and the AM/PM
+// designation of %p, follow the LC_TIME locale, as with strftime(), but
+// are formatted more quickly when that locale is "C" or "POSIX".
+//
 // Tip: Format strings should include the UTC offset (e.g., %z, %Ez, or %E*z)
 // so that the resulting string uniquely identifies an absolute time.
 //
@@ -317,6 +445,153 @@ inline std::string format(const std::string& fmt, const time_point<D>& tp,
   return detail::format(fmt, p.first, n, tz);
 }
 
+// As above, but writes the result into the caller's buffer, or appends it
+// to the caller's string, and returns its length, so that a caller who
+// reuses the buffer or string can format without any allocation. Only the
+// first size characters are written to buf, without a NUL terminator, so
+// the result has been truncated when the returned length exceeds size.
+// (The fmt string is still a std::string, so keep one around rather than
+// passing a long literal, or use a format_plan.)
+//
+// Example:
+//   char buf[64];
+//   std::size_t n = cctz::format("%H:%M:%S", tp, lax, buf, sizeof(buf));
+//   if (n <= sizeof(buf)) out.write(buf, n);  // "03:04:05"
+template <typename D>
+inline std::size_t format(const std::string& fmt, const time_point<D>& tp,
+                          const time_zone& tz, char* buf, std::size_t size) {
+  const auto p = detail::split_seconds(tp);
+  const auto n = std::chrono::duration_cast<detail::femtoseconds>(p.second);
+  return detail::format(fmt, p.first, n, tz, buf, size);
+}
+template <typename D>
+inline std::size_t format(const std::string& fmt, const time_point<D>& tp,
+                          const time_zone& tz, std::string* out) {
+  const auto p = detail::split_seconds(tp);
+  const auto n = std::chrono::duration_cast<detail::femtoseconds>(p.second);
+  return detail::format(fmt, p.first, n, tz, out);
+}
+
+// A format_plan is a format string for cctz::format() that has been
+// analyzed once, so that it may then format many time_points without
+// scanning the format each time. This is worthwhile when, like in a log
+// writer, the same few formats are used over and over.
+//
+//   plan.format(tp, tz) == cctz::format(fmt, tp, tz)
+//
+// when the LC_TIME locale is "C" or "POSIX". Otherwise the names of days
+// and months, and the AM/PM designation, are those of the "C" locale
+// unless the plan is locale_aware, in which case they are formatted by
+// strftime() in the LC_TIME locale, as format() would.
+//
+// Example:
+//   const cctz::format_plan plan("%Y-%m-%d%ET%H:%M:%E6S%Ez");
+//   for (const auto& tp : tps) {
+//     out << plan.format(tp, tz) << "\n";
+//   }
+class format_plan;
+struct format_arena;
+namespace detail {
+void format_many(const format_plan&, const time_point<seconds>*,
+                 const femtoseconds*, std::size_t, time_zone::cursor*,
+                 format_arena*);
+}  // namespace detail
+class format_plan {
+ public:
+  explicit format_plan(const std::string& fmt, bool locale_aware = false);
+
+  template <typename D>
+  std::string format(const time_point<D>& tp, const time_zone& tz) const {
+    const auto p = detail::split_seconds(tp);
+    const auto n = std::chrono::duration_cast<detail::femtoseconds>(p.second);
+    return format(p.first, n, tz);
+  }
+
+  // Like the cctz::format() overloads that write into a caller's buffer,
+  // or append to a caller's string, and return the length of the result.
+  template <typename D>
+  std::size_t format(const time_point<D>& tp, const time_zone& tz,
+                     char* buf, std::size_t size) const {
+    const auto p = detail::split_seconds(tp);
+    const auto n = std::chrono::duration_cast<detail::femtoseconds>(p.second);
+    return format(p.first, n, tz, buf, size);
+  }
+  template <typename D>
+  std::size_t format(const time_point<D>& tp, const time_zone& tz,
+                     std::string* out) const {
+    const auto p = detail::split_seconds(tp);
+    const auto n = std::chrono::duration_cast<detail::femtoseconds>(p.second);
+    return format(p.first, n, tz, out);
+  }
+
+ private:
+  std::string format(const time_point<seconds>& tp,
+                     const detail::femtoseconds& fs,
+                     const time_zone& tz) const;
+  std::size_t format(const time_point<seconds>& tp,
+                     const detail::femtoseconds& fs, const time_zone& tz,
+                     char* buf, std::size_t size) const;
+  std::size_t format(const time_point<seconds>& tp,
+                     const detail::femtoseconds& fs, const time_zone& tz,
+                     std::string* out) const;
+
+  friend void detail::format_many(const format_plan&,
+                                 const time_point<seconds>*,
+                                 const detail::femtoseconds*, std::size_t,
+                                 time_zone::cursor*, format_arena*);
+
+  std::vector<detail::format_op> ops_;
+  std::size_t size_hint_;  // the expected length of a result
+  bool needs_tm_;          // whether any op uses strftime()
+};
+
+// A column of strings stored back to back in a single buffer, with the
+// offsets of their boundaries, as in an Arrow string column. The i'th
+// string is data[offsets[i] .. offsets[i + 1]), so a column of n strings
+// has n + 1 offsets.
+struct format_arena {
+  std::string data;
+  std::vector<std::size_t> offsets;
+
+  std::size_t size() const {
+    return offsets.empty() ? 0 : offsets.size() - 1;
+  }
+  std::string operator[](std::size_t i) const {
+    return data.substr(offsets[i], offsets[i + 1] - offsets[i]);
+  }
+};
+
+// Formats the n time_points in tps[0 .. n) according to the plan, appending
+// the results to the arena. The results are the same as plan.format(tp, tz)
+// for each tp, but the zone lookups share a time_zone::cursor, so they
+// are cheap when the column is (mostly) sorted, and the arena's buffers
+// grow only a few times over the whole column. This is meant for turning
+// large columns of times into strings, as when exporting a table.
+//
+// Example:
+//   const cctz::format_plan plan("%Y-%m-%d %H:%M:%E6S");
+//   cctz::format_arena column;
+//   cctz::format_many(plan, tps.data(), tps.size(), tz, &column);
+//   for (std::size_t i = 0; i != column.size(); ++i) ... column[i] ...
+template <typename D>
+void format_many(const format_plan& plan, const time_point<D>* tps,
+                 std::size_t n, const time_zone& tz, format_arena* arena) {
+  if (arena->offsets.empty()) arena->offsets.push_back(arena->data.size());
+  time_zone::cursor cur(tz);
+  const std::size_t kChunkSize = 256;
+  time_point<seconds> secs[kChunkSize];
+  detail::femtoseconds fss[kChunkSize];
+  for (std::size_t i = 0; i < n; i += kChunkSize) {
+    const std::size_t chunk = (n - i < kChunkSize) ? n - i : kChunkSize;
+    for (std::size_t j = 0; j != chunk; ++j) {
+      const auto p = detail::split_seconds(tps[i + j]);
+      secs[j] = p.first;
+      fss[j] = std::chrono::duration_cast<detail::femtoseconds>(p.second);
+    }
+    detail::format_many(plan, secs, fss, chunk, &cur, arena);
+  }
+}
+
 // Parses an input string according to the provided format string and
 // returns the corresponding time_point. Uses strftime()-like formatting
 // options, with the same extensions as cctz::format(), but with the
@@ -372,6 +647,100 @@ inline bool parse(const std::string& fmt, const std::string& input,
          detail::join_seconds(sec, fs, tpp);
 }
 
+// A parse_plan is a format string for cctz::parse() that has been analyzed
+// once, so that it may then parse many inputs without scanning the format
+// each time, and without any per-input allocation (unless the format has
+// specifiers, like %p, that fall back to strptime()).
+//
+//   plan.parse(input, tz, &tp) == cctz::parse(fmt, input, tz, &tp)
+//
+// Example:
+//   const cctz::parse_plan plan("%Y-%m-%d%ET%H:%M:%E*S%Ez");
+//   std::chrono::system_clock::time_point tp;
+//   for (const std::string& line : lines) {
+//     if (!plan.parse(line, tz, &tp)) { ... }
+//   }
+class parse_plan;
+namespace detail {
+void parse_many(const parse_plan&, const char* const*, const std::size_t*,
+                std::size_t, const time_zone&, time_point<seconds>*,
+                femtoseconds*, bool*);
+}  // namespace detail
+class parse_plan {
+ public:
+  explicit parse_plan(const std::string& fmt);
+
+  template <typename D>
+  bool parse(const std::string& input, const time_zone& tz,
+             time_point<D>* tpp) const {
+    time_point<seconds> sec;
+    detail::femtoseconds fs;
+    return parse(input, tz, &sec, &fs) && detail::join_seconds(sec, fs, tpp);
+  }
+
+ private:
+  bool parse(const std::string& input, const time_zone& tz,
+             time_point<seconds>* sec, detail::femtoseconds* fs) const;
+
+  friend void detail::parse_many(const parse_plan&, const char* const*,
+                                 const std::size_t*, std::size_t,
+                                 const time_zone&, time_point<seconds>*,
+                                 detail::femtoseconds*, bool*);
+
+  std::vector<detail::parse_op> ops_;
+};
+
+// Parses the n strings in inputs[0 .. n) according to the plan, storing
+// the results in tps[0 .. n), and returns the number of inputs that fail.
+// The results are the same as plan.parse(inputs[i], tz, &tps[i]), except
+// that the inputs may be of any string type with data() and size() (for
+// example, std::string_view slices of a file), and the zone lookups are
+// done in batches, so that they follow the rows through the zone's
+// transitions rather than starting afresh on each row. tps[i] is left
+// unchanged when inputs[i] fails.
+//
+// If errors is not null it receives a bitmap of the failures, with bit
+// (i % 8) of errors[i / 8] set when inputs[i] fails, so it must hold
+// (n + 7) / 8 bytes. This is the inverse of an Arrow validity bitmap.
+//
+// Example:
+//   const cctz::parse_plan plan("%Y-%m-%d%ET%H:%M:%E*S%Ez");
+//   std::vector<std::chrono::system_clock::time_point> tps(fields.size());
+//   std::vector<std::uint_least8_t> errors((fields.size() + 7) / 8);
+//   if (cctz::parse_many(plan, fields.data(), fields.size(), tz, tps.data(),
+//                        errors.data()) != 0) { ... }
+template <typename S, typename D>
+std::size_t parse_many(const parse_plan& plan, const S* inputs, std::size_t n,
+                       const time_zone& tz, time_point<D>* tps,
+                       std::uint_least8_t* errors) {
+  const std::size_t kChunkSize = 256;  // a multiple of 8
+  const char* data[kChunkSize];
+  std::size_t sizes[kChunkSize];
+  time_point<seconds> secs[kChunkSize];
+  detail::femtoseconds fss[kChunkSize];
+  bool oks[kChunkSize];
+  std::size_t failures = 0;
+  for (std::size_t i = 0; i < n; i += kChunkSize) {
+    const std::size_t chunk = (n - i < kChunkSize) ? n - i : kChunkSize;
+    for (std::size_t j = 0; j != chunk; ++j) {
+      data[j] = inputs[i + j].data();
+      sizes[j] = inputs[i + j].size();
+    }
+    detail::parse_many(plan, data, sizes, chunk, tz, secs, fss, oks);
+    for (std::size_t j = 0; j != chunk; ++j) {
+      const bool ok =
+          oks[j] && detail::join_seconds(secs[j], fss[j], &tps[i + j]);
+      if (!ok) ++failures;
+      if (errors != nullptr) {
+        std::uint_least8_t& bits = errors[(i + j) / 8];
+        if (j % 8 == 0) bits = 0;
+        if (!ok) bits |= static_cast<std::uint_least8_t>(1u << (j % 8));
+      }
+    }
+  }
+  return failures;
+}
+
 namespace detail {
 
 // Split a time_point<D> into a time_point<seconds> and a D subseconds.
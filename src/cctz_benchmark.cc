@@ -15,6 +15,8 @@
 #include <algorithm>
 #include <cassert>
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <ctime>
 #include <random>
 #include <string>
@@ -24,6 +26,7 @@
 #include "cctz/civil_time.h"
 #include "cctz/time_zone.h"
 #include "time_zone_impl.h"
+#include "time_zone_info.h"
 
 namespace {
 
@@ -45,6 +48,115 @@ void BM_Step_Days(benchmark::State& state) {
 }
 BENCHMARK(BM_Step_Days);
 
+void BM_Step_EpochSeconds(benchmark::State& state) {
+  const cctz::civil_second epoch(1970, 1, 1, 0, 0, 0);
+  std::int_fast64_t n = 1384569027;
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(epoch + n);
+    n += 86400 + 1;
+  }
+}
+BENCHMARK(BM_Step_EpochSeconds);
+
+// The "Loop" benchmarks do day arithmetic on an array of civil times one
+// at a time, while the "Batch" benchmarks use the batch forms.
+
+template <typename T>
+std::vector<T> BatchDays() {
+  std::vector<T> cs;
+  cctz::civil_second c(2010, 1, 1, 12, 34, 56);
+  for (int i = 0; i != 4096; ++i) {
+    cs.push_back(T(c));
+    c += 7 * 3600 + 17;
+  }
+  return cs;
+}
+
+template <typename T>
+void BM_Difference_DaysLoop(benchmark::State& state) {
+  const auto cs = BatchDays<T>();
+  const cctz::civil_day epoch(1970, 1, 1);
+  std::vector<cctz::diff_t> out(cs.size());
+  while (state.KeepRunningBatch(static_cast<std::int64_t>(cs.size()))) {
+    for (std::size_t i = 0; i != cs.size(); ++i) {
+      out[i] = cctz::civil_day(cs[i]) - epoch;
+    }
+    benchmark::DoNotOptimize(out.data());
+  }
+}
+BENCHMARK_TEMPLATE(BM_Difference_DaysLoop, cctz::civil_day);
+BENCHMARK_TEMPLATE(BM_Difference_DaysLoop, cctz::civil_second);
+
+template <typename T>
+void BM_Difference_DaysBatch(benchmark::State& state) {
+  const auto cs = BatchDays<T>();
+  const cctz::civil_day epoch(1970, 1, 1);
+  std::vector<cctz::diff_t> out(cs.size());
+  while (state.KeepRunningBatch(static_cast<std::int64_t>(cs.size()))) {
+    cctz::day_differences(cs.data(), cs.size(), epoch, out.data());
+    benchmark::DoNotOptimize(out.data());
+  }
+}
+BENCHMARK_TEMPLATE(BM_Difference_DaysBatch, cctz::civil_day);
+BENCHMARK_TEMPLATE(BM_Difference_DaysBatch, cctz::civil_second);
+
+cctz::civil_day AddDays(const cctz::civil_day& cd, int n) { return cd + n; }
+cctz::civil_second AddDays(const cctz::civil_second& cs, int n) {
+  return cs + n * 86400;
+}
+
+template <typename T>
+void BM_Step_DaysLoop(benchmark::State& state) {
+  const auto cs = BatchDays<T>();
+  std::vector<T> out(cs.size());
+  while (state.KeepRunningBatch(static_cast<std::int64_t>(cs.size()))) {
+    for (std::size_t i = 0; i != cs.size(); ++i) {
+      out[i] = AddDays(cs[i], 40);
+    }
+    benchmark::DoNotOptimize(out.data());
+  }
+}
+BENCHMARK_TEMPLATE(BM_Step_DaysLoop, cctz::civil_day);
+BENCHMARK_TEMPLATE(BM_Step_DaysLoop, cctz::civil_second);
+
+template <typename T>
+void BM_Step_DaysBatch(benchmark::State& state) {
+  const auto cs = BatchDays<T>();
+  std::vector<T> out(cs.size());
+  while (state.KeepRunningBatch(static_cast<std::int64_t>(cs.size()))) {
+    cctz::step_days(cs.data(), cs.size(), 40, out.data());
+    benchmark::DoNotOptimize(out.data());
+  }
+}
+BENCHMARK_TEMPLATE(BM_Step_DaysBatch, cctz::civil_day);
+BENCHMARK_TEMPLATE(BM_Step_DaysBatch, cctz::civil_second);
+
+template <typename T>
+void BM_GetWeekdayLoop(benchmark::State& state) {
+  const auto cs = BatchDays<T>();
+  std::vector<cctz::weekday> out(cs.size());
+  while (state.KeepRunningBatch(static_cast<std::int64_t>(cs.size()))) {
+    for (std::size_t i = 0; i != cs.size(); ++i) {
+      out[i] = cctz::get_weekday(cs[i]);
+    }
+    benchmark::DoNotOptimize(out.data());
+  }
+}
+BENCHMARK_TEMPLATE(BM_GetWeekdayLoop, cctz::civil_day);
+BENCHMARK_TEMPLATE(BM_GetWeekdayLoop, cctz::civil_second);
+
+template <typename T>
+void BM_GetWeekdayBatch(benchmark::State& state) {
+  const auto cs = BatchDays<T>();
+  std::vector<cctz::weekday> out(cs.size());
+  while (state.KeepRunningBatch(static_cast<std::int64_t>(cs.size()))) {
+    cctz::get_weekdays(cs.data(), cs.size(), out.data());
+    benchmark::DoNotOptimize(out.data());
+  }
+}
+BENCHMARK_TEMPLATE(BM_GetWeekdayBatch, cctz::civil_day);
+BENCHMARK_TEMPLATE(BM_GetWeekdayBatch, cctz::civil_second);
+
 void BM_GetWeekday(benchmark::State& state) {
   const cctz::civil_day c(2014, 8, 22);
   while (state.KeepRunning()) {
@@ -765,6 +877,16 @@ void BM_Zone_LoadTimeZoneCached(benchmark::State& state) {
 }
 BENCHMARK(BM_Zone_LoadTimeZoneCached);
 
+void BM_Zone_LoadTimeZoneCachedThreaded(benchmark::State& state) {
+  cctz::time_zone tz;
+  const std::string name = "file:America/Los_Angeles";
+  cctz::load_time_zone(name, &tz);  // prime cache
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(cctz::load_time_zone(name, &tz));
+  }
+}
+BENCHMARK(BM_Zone_LoadTimeZoneCachedThreaded)->ThreadRange(1, 8)->UseRealTime();
+
 void BM_Zone_LoadLocalTimeZoneCached(benchmark::State& state) {
   cctz::utc_time_zone();  // in case we're first
   cctz::time_zone::Impl::ClearTimeZoneMapTestOnly();
@@ -833,7 +955,7 @@ BENCHMARK(BM_Zone_UTCTimeZone);
 
 // In each "ToCivil" benchmark we switch between two instants separated
 // by at least one transition in order to defeat any internal caching of
-// previous results (e.g., see local_time_hint_).
+// previous results (e.g., see ThreadHints() in time_zone_info.cc).
 //
 // The "UTC" variants use UTC instead of the Google/local time zone.
 
@@ -893,9 +1015,188 @@ void BM_Time_ToCivilUTC_Libc(benchmark::State& state) {
 }
 BENCHMARK(BM_Time_ToCivilUTC_Libc);
 
+// The "Batch" benchmarks compare a loop of scalar conversions with a single
+// batch conversion of the same instants, which are either sorted (hourly
+// from 2010 onwards, so crossing several transitions) or shuffled. The
+// "Cursor" benchmark converts them with a time_zone::cursor.
+
+std::vector<cctz::time_point<cctz::seconds>> BatchInstants(bool sorted) {
+  std::vector<cctz::time_point<cctz::seconds>> tps;
+  auto tp = std::chrono::time_point_cast<cctz::seconds>(
+      std::chrono::system_clock::from_time_t(1262304000));  // 2010-01-01
+  for (int i = 0; i != 8 * 365 * 24; ++i) {
+    tps.push_back(tp);
+    tp += std::chrono::hours(1);
+  }
+  if (!sorted) {
+    std::mt19937 urbg(42);  // a UniformRandomBitGenerator with fixed seed
+    std::shuffle(tps.begin(), tps.end(), urbg);
+  }
+  return tps;
+}
+
+void BM_Time_ToCivilLoop_CCTZ(benchmark::State& state) {
+  const cctz::time_zone tz = TestTimeZone();
+  const auto tps = BatchInstants(state.range(0) != 0);
+  std::vector<cctz::time_zone::absolute_lookup> als(tps.size());
+  while (state.KeepRunningBatch(static_cast<std::int64_t>(tps.size()))) {
+    for (std::size_t i = 0; i != tps.size(); ++i) {
+      als[i] = tz.lookup(tps[i]);
+    }
+    benchmark::DoNotOptimize(als.data());
+  }
+}
+BENCHMARK(BM_Time_ToCivilLoop_CCTZ)->Arg(1)->Arg(0);
+
+void BM_Time_ToCivilBatch_CCTZ(benchmark::State& state) {
+  const cctz::time_zone tz = TestTimeZone();
+  const auto tps = BatchInstants(state.range(0) != 0);
+  std::vector<cctz::time_zone::absolute_lookup> als(tps.size());
+  while (state.KeepRunningBatch(static_cast<std::int64_t>(tps.size()))) {
+    tz.lookup(tps.data(), tps.size(), als.data());
+    benchmark::DoNotOptimize(als.data());
+  }
+}
+BENCHMARK(BM_Time_ToCivilBatch_CCTZ)->Arg(1)->Arg(0);
+
+void BM_Time_ToCivilCursor_CCTZ(benchmark::State& state) {
+  const cctz::time_zone tz = TestTimeZone();
+  const auto tps = BatchInstants(state.range(0) != 0);
+  std::vector<cctz::time_zone::absolute_lookup> als(tps.size());
+  while (state.KeepRunningBatch(static_cast<std::int64_t>(tps.size()))) {
+    cctz::time_zone::cursor cur(tz);
+    for (std::size_t i = 0; i != tps.size(); ++i) {
+      als[i] = cur.lookup(tps[i]);
+    }
+    benchmark::DoNotOptimize(als.data());
+  }
+}
+BENCHMARK(BM_Time_ToCivilCursor_CCTZ)->Arg(1)->Arg(0);
+
+// The "Random" benchmarks convert instants drawn uniformly from the whole
+// range of transitions in the test time zone, so that neither the cached
+// hints nor branch prediction help to find the surrounding transitions.
+
+std::vector<cctz::time_point<cctz::seconds>> RandomInstants() {
+  const cctz::time_zone tz = TestTimeZone();
+  cctz::time_zone::civil_transition first, last;
+  tz.next_transition(cctz::time_point<cctz::seconds>::min(), &first);
+  tz.prev_transition(cctz::time_point<cctz::seconds>::max(), &last);
+  std::uniform_int_distribution<std::int_fast64_t> dist(
+      cctz::convert(first.to, tz).time_since_epoch().count(),
+      cctz::convert(last.to, tz).time_since_epoch().count());
+  std::mt19937 urbg(42);  // a UniformRandomBitGenerator with fixed seed
+  std::vector<cctz::time_point<cctz::seconds>> tps;
+  for (int i = 0; i != 4096; ++i) {
+    tps.push_back(cctz::time_point<cctz::seconds>() +
+                  cctz::seconds(dist(urbg)));
+  }
+  return tps;
+}
+
+void BM_Time_ToCivilRandom_CCTZ(benchmark::State& state) {
+  const cctz::time_zone tz = TestTimeZone();
+  const auto tps = RandomInstants();
+  std::size_t i = 0;
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(tz.lookup(tps[i]));
+    if (++i == tps.size()) i = 0;
+  }
+}
+BENCHMARK(BM_Time_ToCivilRandom_CCTZ);
+
+// The "Threads" benchmarks have each thread convert hourly instants from
+// its own era of the test time zone, so that a thread's consecutive
+// lookups usually fall between the same transitions, while different
+// threads' lookups do not. The lookup hints are kept per thread, so each
+// should see the hint hit rate of a single thread, and the throughput
+// should scale with the number of threads. The "hits" counter is the
+// measured fraction of the hint checks that the hint satisfied.
+
+std::vector<cctz::time_point<cctz::seconds>> EraInstants(int thread) {
+  const cctz::time_zone tz = TestTimeZone();
+  auto tp = cctz::convert(cctz::civil_second(1975 + 7 * thread, 1, 1), tz);
+  std::vector<cctz::time_point<cctz::seconds>> tps;
+  for (int i = 0; i != 4096; ++i) {
+    tps.push_back(tp);
+    tp += cctz::seconds(60 * 60);
+  }
+  return tps;
+}
+
+// The hit rate of the calling thread's hint checks since "before".
+double HintHitRate(const cctz::TimeZoneInfo::HintStats& before) {
+  const cctz::TimeZoneInfo::HintStats after =
+      cctz::TimeZoneInfo::ThreadHintStatsTestOnly();
+  const auto checks = after.checks - before.checks;
+  if (checks == 0) return 0;
+  return static_cast<double>(after.hits - before.hits) /
+         static_cast<double>(checks);
+}
+
+void BM_Time_ToCivilThreads_CCTZ(benchmark::State& state) {
+  const cctz::time_zone tz = TestTimeZone();
+  const auto tps = EraInstants(state.thread_index());
+  const auto stats = cctz::TimeZoneInfo::ThreadHintStatsTestOnly();
+  std::size_t i = 0;
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(tz.lookup(tps[i]));
+    if (++i == tps.size()) i = 0;
+  }
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()));
+  state.counters["hits"] =
+      benchmark::Counter(HintHitRate(stats), benchmark::Counter::kAvgThreads);
+}
+BENCHMARK(BM_Time_ToCivilThreads_CCTZ)->ThreadRange(1, 16)->UseRealTime();
+
+void BM_Time_FromCivilThreads_CCTZ(benchmark::State& state) {
+  const cctz::time_zone tz = TestTimeZone();
+  const auto tps = EraInstants(state.thread_index());
+  std::vector<cctz::civil_second> css;
+  for (const auto& tp : tps) css.push_back(cctz::convert(tp, tz));
+  const auto stats = cctz::TimeZoneInfo::ThreadHintStatsTestOnly();
+  std::size_t i = 0;
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(tz.lookup(css[i]));
+    if (++i == css.size()) i = 0;
+  }
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()));
+  state.counters["hits"] =
+      benchmark::Counter(HintHitRate(stats), benchmark::Counter::kAvgThreads);
+}
+BENCHMARK(BM_Time_FromCivilThreads_CCTZ)->ThreadRange(1, 16)->UseRealTime();
+
+// The "Future" benchmarks convert instants drawn from the years 2500 to
+// 3000, beyond the transitions generated from the future rules of the test
+// time zone, and so computed directly from those rules.
+
+std::vector<cctz::time_point<cctz::seconds>> FutureInstants() {
+  std::uniform_int_distribution<std::int_fast64_t> dist(
+      cctz::civil_second(2500, 1, 1) - cctz::civil_second(),
+      cctz::civil_second(3000, 1, 1) - cctz::civil_second());
+  std::mt19937 urbg(42);  // a UniformRandomBitGenerator with fixed seed
+  std::vector<cctz::time_point<cctz::seconds>> tps;
+  for (int i = 0; i != 4096; ++i) {
+    tps.push_back(cctz::time_point<cctz::seconds>() +
+                  cctz::seconds(dist(urbg)));
+  }
+  return tps;
+}
+
+void BM_Time_ToCivilFuture_CCTZ(benchmark::State& state) {
+  const cctz::time_zone tz = TestTimeZone();
+  const auto tps = FutureInstants();
+  std::size_t i = 0;
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(tz.lookup(tps[i]));
+    if (++i == tps.size()) i = 0;
+  }
+}
+BENCHMARK(BM_Time_ToCivilFuture_CCTZ);
+
 // In each "FromCivil" benchmark we switch between two YMDhms values
 // separated by at least one transition in order to defeat any internal
-// caching of previous results (e.g., see time_local_hint_).
+// caching of previous results (e.g., see ThreadHints() in time_zone_info.cc).
 //
 // The "UTC" variants use UTC instead of the Google/local time zone.
 // The "Day0" variants require normalization of the day of month.
@@ -952,6 +1253,74 @@ BENCHMARK(BM_Time_FromCivilUTC_CCTZ);
 
 // There is no BM_Time_FromCivilUTC_Libc.
 
+// As with the "ToCivil" batch benchmarks, but for the civil times of the
+// BatchInstants() in the test time zone.
+
+std::vector<cctz::civil_second> BatchCivilTimes(bool sorted) {
+  const cctz::time_zone tz = TestTimeZone();
+  std::vector<cctz::civil_second> css;
+  for (const auto& tp : BatchInstants(sorted)) {
+    css.push_back(cctz::convert(tp, tz));
+  }
+  return css;
+}
+
+void BM_Time_FromCivilLoop_CCTZ(benchmark::State& state) {
+  const cctz::time_zone tz = TestTimeZone();
+  const auto css = BatchCivilTimes(state.range(0) != 0);
+  std::vector<cctz::time_zone::civil_lookup> cls(css.size());
+  while (state.KeepRunningBatch(static_cast<std::int64_t>(css.size()))) {
+    for (std::size_t i = 0; i != css.size(); ++i) {
+      cls[i] = tz.lookup(css[i]);
+    }
+    benchmark::DoNotOptimize(cls.data());
+  }
+}
+BENCHMARK(BM_Time_FromCivilLoop_CCTZ)->Arg(1)->Arg(0);
+
+void BM_Time_FromCivilBatch_CCTZ(benchmark::State& state) {
+  const cctz::time_zone tz = TestTimeZone();
+  const auto css = BatchCivilTimes(state.range(0) != 0);
+  std::vector<cctz::time_zone::civil_lookup> cls(css.size());
+  std::vector<std::uint_least8_t> kinds(css.size());
+  while (state.KeepRunningBatch(static_cast<std::int64_t>(css.size()))) {
+    benchmark::DoNotOptimize(
+        tz.lookup(css.data(), css.size(), cls.data(), kinds.data()));
+  }
+}
+BENCHMARK(BM_Time_FromCivilBatch_CCTZ)->Arg(1)->Arg(0);
+
+// As with BM_Time_ToCivilRandom_CCTZ, but for the civil times of the
+// RandomInstants() in the test time zone.
+
+void BM_Time_FromCivilRandom_CCTZ(benchmark::State& state) {
+  const cctz::time_zone tz = TestTimeZone();
+  std::vector<cctz::civil_second> css;
+  for (const auto& tp : RandomInstants()) {
+    css.push_back(cctz::convert(tp, tz));
+  }
+  std::size_t i = 0;
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(tz.lookup(css[i]));
+    if (++i == css.size()) i = 0;
+  }
+}
+BENCHMARK(BM_Time_FromCivilRandom_CCTZ);
+
+void BM_Time_FromCivilFuture_CCTZ(benchmark::State& state) {
+  const cctz::time_zone tz = TestTimeZone();
+  std::vector<cctz::civil_second> css;
+  for (const auto& tp : FutureInstants()) {
+    css.push_back(cctz::convert(tp, tz));
+  }
+  std::size_t i = 0;
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(tz.lookup(css[i]));
+    if (++i == css.size()) i = 0;
+  }
+}
+BENCHMARK(BM_Time_FromCivilFuture_CCTZ);
+
 void BM_Time_FromCivilDay0_CCTZ(benchmark::State& state) {
   const cctz::time_zone tz = TestTimeZone();
   int i = 0;
@@ -1016,6 +1385,94 @@ void BM_Format_FormatTime(benchmark::State& state) {
 }
 BENCHMARK(BM_Format_FormatTime)->DenseRange(0, kNumFormats - 1);
 
+void BM_Format_FormatPlan(benchmark::State& state) {
+  const cctz::format_plan plan(kFormats[state.range(0)]);
+  state.SetLabel(kFormats[state.range(0)]);
+  const cctz::time_zone tz = TestTimeZone();
+  const std::chrono::system_clock::time_point tp =
+      cctz::convert(cctz::civil_second(1977, 6, 28, 9, 8, 7), tz) +
+      std::chrono::microseconds(1);
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(plan.format(tp, tz));
+  }
+}
+BENCHMARK(BM_Format_FormatPlan)->DenseRange(0, kNumFormats - 1);
+
+void BM_Format_FormatBuffer(benchmark::State& state) {
+  const std::string fmt = kFormats[state.range(0)];
+  state.SetLabel(fmt);
+  const cctz::time_zone tz = TestTimeZone();
+  const std::chrono::system_clock::time_point tp =
+      cctz::convert(cctz::civil_second(1977, 6, 28, 9, 8, 7), tz) +
+      std::chrono::microseconds(1);
+  char buf[128];
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(cctz::format(fmt, tp, tz, buf, sizeof(buf)));
+  }
+}
+BENCHMARK(BM_Format_FormatBuffer)->DenseRange(0, kNumFormats - 1);
+
+void BM_Format_FormatPlanBuffer(benchmark::State& state) {
+  const cctz::format_plan plan(kFormats[state.range(0)]);
+  state.SetLabel(kFormats[state.range(0)]);
+  const cctz::time_zone tz = TestTimeZone();
+  const std::chrono::system_clock::time_point tp =
+      cctz::convert(cctz::civil_second(1977, 6, 28, 9, 8, 7), tz) +
+      std::chrono::microseconds(1);
+  char buf[128];
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(plan.format(tp, tz, buf, sizeof(buf)));
+  }
+}
+BENCHMARK(BM_Format_FormatPlanBuffer)->DenseRange(0, kNumFormats - 1);
+
+// A column of times an hour and a bit apart, for the batch formatting.
+std::vector<std::chrono::system_clock::time_point> FormatColumn(
+    const cctz::time_zone& tz) {
+  std::vector<std::chrono::system_clock::time_point> tps;
+  std::chrono::system_clock::time_point tp =
+      cctz::convert(cctz::civil_second(1977, 6, 28, 9, 8, 7), tz);
+  for (int i = 0; i != 1024; ++i) {
+    tps.push_back(tp);
+    tp += std::chrono::seconds(3600 + i) + std::chrono::microseconds(i);
+  }
+  return tps;
+}
+
+void BM_Format_FormatPlanColumn(benchmark::State& state) {
+  const cctz::format_plan plan(kFormats[state.range(0)]);
+  state.SetLabel(kFormats[state.range(0)]);
+  const cctz::time_zone tz = TestTimeZone();
+  const auto tps = FormatColumn(tz);
+  while (state.KeepRunning()) {
+    std::string data;
+    std::vector<std::size_t> offsets(1, 0);
+    for (const auto& tp : tps) {
+      plan.format(tp, tz, &data);
+      offsets.push_back(data.size());
+    }
+    benchmark::DoNotOptimize(data);
+  }
+  state.SetItemsProcessed(
+      static_cast<std::int64_t>(state.iterations() * tps.size()));
+}
+BENCHMARK(BM_Format_FormatPlanColumn)->DenseRange(0, kNumFormats - 1);
+
+void BM_Format_FormatMany(benchmark::State& state) {
+  const cctz::format_plan plan(kFormats[state.range(0)]);
+  state.SetLabel(kFormats[state.range(0)]);
+  const cctz::time_zone tz = TestTimeZone();
+  const auto tps = FormatColumn(tz);
+  while (state.KeepRunning()) {
+    cctz::format_arena column;
+    cctz::format_many(plan, tps.data(), tps.size(), tz, &column);
+    benchmark::DoNotOptimize(column.data);
+  }
+  state.SetItemsProcessed(
+      static_cast<std::int64_t>(state.iterations() * tps.size()));
+}
+BENCHMARK(BM_Format_FormatMany)->DenseRange(0, kNumFormats - 1);
+
 void BM_Format_ParseTime(benchmark::State& state) {
   const std::string fmt = kFormats[state.range(0)];
   state.SetLabel(fmt);
@@ -1030,4 +1487,79 @@ void BM_Format_ParseTime(benchmark::State& state) {
 }
 BENCHMARK(BM_Format_ParseTime)->DenseRange(0, kNumFormats - 1);
 
+void BM_Format_ParsePlan(benchmark::State& state) {
+  const cctz::parse_plan plan(kFormats[state.range(0)]);
+  state.SetLabel(kFormats[state.range(0)]);
+  const cctz::time_zone tz = TestTimeZone();
+  std::chrono::system_clock::time_point tp =
+      cctz::convert(cctz::civil_second(1977, 6, 28, 9, 8, 7), tz) +
+      std::chrono::microseconds(1);
+  const std::string when = cctz::format(kFormats[state.range(0)], tp, tz);
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(plan.parse(when, tz, &tp));
+  }
+}
+BENCHMARK(BM_Format_ParsePlan)->DenseRange(0, kNumFormats - 1);
+
+// A field of a CSV line, which is not NUL terminated.
+struct Field {
+  const char* p;
+  std::size_t n;
+  const char* data() const { return p; }
+  std::size_t size() const { return n; }
+};
+
+// The FormatColumn() times, formatted back to back in one buffer, with
+// the fields that slice it.
+std::vector<Field> ParseColumn(const char* fmt, const cctz::time_zone& tz,
+                               std::string* buffer) {
+  std::vector<std::size_t> sizes;
+  for (const auto& tp : FormatColumn(tz)) {
+    sizes.push_back(cctz::format(fmt, tp, tz, buffer));
+  }
+  std::vector<Field> fields;
+  const char* p = buffer->data();
+  for (std::size_t size : sizes) {
+    fields.push_back({p, size});
+    p += size;
+  }
+  return fields;
+}
+
+void BM_Format_ParsePlanColumn(benchmark::State& state) {
+  const cctz::parse_plan plan(kFormats[state.range(0)]);
+  state.SetLabel(kFormats[state.range(0)]);
+  const cctz::time_zone tz = TestTimeZone();
+  std::string buffer;
+  const auto fields = ParseColumn(kFormats[state.range(0)], tz, &buffer);
+  std::vector<std::chrono::system_clock::time_point> tps(fields.size());
+  while (state.KeepRunning()) {
+    for (std::size_t i = 0; i != fields.size(); ++i) {
+      const std::string input(fields[i].data(), fields[i].size());
+      benchmark::DoNotOptimize(plan.parse(input, tz, &tps[i]));
+    }
+  }
+  state.SetItemsProcessed(
+      static_cast<std::int64_t>(state.iterations() * fields.size()));
+}
+BENCHMARK(BM_Format_ParsePlanColumn)->DenseRange(0, kNumFormats - 1);
+
+void BM_Format_ParseMany(benchmark::State& state) {
+  const cctz::parse_plan plan(kFormats[state.range(0)]);
+  state.SetLabel(kFormats[state.range(0)]);
+  const cctz::time_zone tz = TestTimeZone();
+  std::string buffer;
+  const auto fields = ParseColumn(kFormats[state.range(0)], tz, &buffer);
+  std::vector<std::chrono::system_clock::time_point> tps(fields.size());
+  std::vector<std::uint_least8_t> errors((fields.size() + 7) / 8);
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(cctz::parse_many(plan, fields.data(),
+                                              fields.size(), tz, tps.data(),
+                                              errors.data()));
+  }
+  state.SetItemsProcessed(
+      static_cast<std::int64_t>(state.iterations() * fields.size()));
+}
+BENCHMARK(BM_Format_ParseMany)->DenseRange(0, kNumFormats - 1);
+
 }  // namespace
@@ -14,6 +14,14 @@
 
 #include "cctz/civil_time_detail.h"
 
+#if defined(__x86_64__) && defined(__linux__) && \
+    (defined(__GNUC__) || defined(__clang__))
+#define CCTZ_HAVE_X86_KERNELS 1
+#endif
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <iomanip>
 #include <ostream>
 #include <sstream>
@@ -21,6 +29,259 @@
 namespace cctz {
 namespace detail {
 
+namespace {
+
+// The batch day arithmetic converts blocks of dates to and from day
+// ordinals using Howard Hinnant's days_from_civil() and civil_from_days()
+// algorithms, with each date in a 32-bit lane. Every kernel loop has the
+// same fixed trip count, and no branches, so that the compiler turns it
+// into vector code. Years are offset by a whole number of 400-year eras
+// so that the kernels need only unsigned arithmetic.
+constexpr std::size_t kBlockSize = 64;
+
+// Dates whose years are within kMaxYear of year 0, and steps of fewer than
+// kMaxDays days, are handled by the kernels. The bias keeps the offset
+// years, and the ordinals measured from the offset 0000-03-01, within the
+// positive range of 32 bits.
+constexpr year_t kMaxYear = 1000000;
+constexpr diff_t kMaxDays = diff_t{1} << 28;  // about 735000 years
+constexpr std::int_fast32_t kEraBias = 5001;  // 400-year eras
+constexpr std::int_fast32_t kYearBias = kEraBias * 400;
+constexpr std::int_fast32_t kOrdBias = kEraBias * 146097 + 719468;
+
+// The weekday (as an offset from monday) of the offset 0000-03-01, which
+// is chosen so that 1970-01-01 (ordinal 0) falls on a thursday.
+constexpr std::int_fast32_t kWeekdayBias = (3 + 7 - kOrdBias % 7) % 7;
+
+// A block of dates, with the years offset by kYearBias.
+struct DateBlock {
+  std::uint32_t y[kBlockSize];
+  std::uint32_t m[kBlockSize];
+  std::uint32_t d[kBlockSize];
+};
+
+// Sets z[i] to the biased ordinal of the date b[i].
+inline void OrdinalKernel(const DateBlock& b, std::uint32_t* z) {
+  for (std::size_t i = 0; i != kBlockSize; ++i) {
+    const std::uint32_t m = b.m[i];
+    const std::uint32_t ey = b.y[i] - (m <= 2 ? 1 : 0);
+    const std::uint32_t era = ey / 400;
+    const std::uint32_t yoe = ey - era * 400;                     // [0:399]
+    const std::uint32_t mp = m > 2 ? m - 3 : m + 9;               // [0:11]
+    const std::uint32_t doy = (153 * mp + 2) / 5 + b.d[i] - 1;    // [0:365]
+    const std::uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    z[i] = era * 146097 + doe;
+  }
+}
+
+// Sets b[i] to the date with the biased ordinal z[i].
+inline void DateKernel(const std::uint32_t* z, DateBlock* b) {
+  for (std::size_t i = 0; i != kBlockSize; ++i) {
+    const std::uint32_t era = z[i] / 146097;
+    const std::uint32_t doe = z[i] - era * 146097;  // [0:146096]
+    const std::uint32_t yoe =
+        (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;  // [0:399]
+    const std::uint32_t doy = doe - (yoe * 365 + yoe / 4 - yoe / 100);
+    const std::uint32_t mp = (5 * doy + 2) / 153;  // [0:11]
+    const std::uint32_t m = mp < 10 ? mp + 3 : mp - 9;
+    b->y[i] = era * 400 + yoe + (m <= 2 ? 1 : 0);
+    b->m[i] = m;
+    b->d[i] = doy - (153 * mp + 2) / 5 + 1;
+  }
+}
+
+// Sets wd[i] to the weekday (as an offset from monday) of the biased
+// ordinal z[i].
+inline void WeekdayKernel(const std::uint32_t* z, std::uint32_t* wd) {
+  for (std::size_t i = 0; i != kBlockSize; ++i) {
+    wd[i] = (z[i] + kWeekdayBias) % 7;
+  }
+}
+
+using OrdinalFn = void (*)(const DateBlock&, std::uint32_t*);
+using DateFn = void (*)(const std::uint32_t*, DateBlock*);
+using WeekdayFn = void (*)(const std::uint32_t*, std::uint32_t*);
+
+void OrdinalsDefault(const DateBlock& b, std::uint32_t* z) {
+  OrdinalKernel(b, z);
+}
+void DatesDefault(const std::uint32_t* z, DateBlock* b) { DateKernel(z, b); }
+void WeekdaysDefault(const std::uint32_t* z, std::uint32_t* wd) {
+  WeekdayKernel(z, wd);
+}
+
+#if defined(CCTZ_HAVE_X86_KERNELS)
+
+__attribute__((target("avx2")))
+void OrdinalsAVX2(const DateBlock& b, std::uint32_t* z) {
+  OrdinalKernel(b, z);
+}
+__attribute__((target("avx2")))
+void DatesAVX2(const std::uint32_t* z, DateBlock* b) {
+  DateKernel(z, b);
+}
+__attribute__((target("avx2")))
+void WeekdaysAVX2(const std::uint32_t* z, std::uint32_t* wd) {
+  WeekdayKernel(z, wd);
+}
+
+#endif  // CCTZ_HAVE_X86_KERNELS
+
+struct Kernels {
+  OrdinalFn ordinals;
+  DateFn dates;
+  WeekdayFn weekdays;
+};
+
+Kernels ChooseKernels() {
+#if defined(CCTZ_HAVE_X86_KERNELS)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return {OrdinalsAVX2, DatesAVX2, WeekdaysAVX2};
+  }
+#endif
+  return {OrdinalsDefault, DatesDefault, WeekdaysDefault};
+}
+
+const Kernels& GetKernels() {
+  static const Kernels kernels = ChooseKernels();
+  return kernels;
+}
+
+bool InKernelRange(year_t y) { return -kMaxYear <= y && y <= kMaxYear; }
+
+// Loads the dates of cs[0, n), where n <= kBlockSize, into the block,
+// filling any unused lanes with a valid date. Returns false if any of the
+// years is out of the range of the kernels.
+template <typename T>
+bool LoadBlock(const T* cs, std::size_t n, DateBlock* b) {
+  bool ok = true;
+  for (std::size_t i = 0; i != n; ++i) {
+    ok &= InKernelRange(cs[i].year());
+    b->y[i] = static_cast<std::uint32_t>(cs[i].year() + kYearBias);
+    b->m[i] = static_cast<std::uint32_t>(cs[i].month());
+    b->d[i] = static_cast<std::uint32_t>(cs[i].day());
+  }
+  for (std::size_t i = n; i != kBlockSize; ++i) {
+    b->y[i] = kYearBias;
+    b->m[i] = 1;
+    b->d[i] = 1;
+  }
+  return ok;
+}
+
+civil_day MakeDay(const DateBlock& b, std::size_t i, const civil_day&) {
+  return civil_day(static_cast<year_t>(b.y[i]) - kYearBias, b.m[i], b.d[i]);
+}
+civil_second MakeDay(const DateBlock& b, std::size_t i,
+                     const civil_second& cs) {
+  return civil_second(static_cast<year_t>(b.y[i]) - kYearBias, b.m[i],
+                      b.d[i], cs.hour(), cs.minute(), cs.second());
+}
+
+civil_day StepDay(const civil_day& cd, diff_t days) { return cd + days; }
+civil_second StepDay(const civil_second& cs, diff_t days) {
+  const civil_day cd = civil_day(cs) + days;
+  return civil_second(cd.year(), cd.month(), cd.day(), cs.hour(), cs.minute(),
+                      cs.second());
+}
+
+template <typename T>
+void GetWeekdays(const T* cs, std::size_t n, weekday* out) {
+  const Kernels& kernels = GetKernels();
+  DateBlock b;
+  std::uint32_t z[kBlockSize];
+  std::uint32_t wd[kBlockSize];
+  while (n != 0) {
+    const std::size_t k = std::min(n, kBlockSize);
+    if (LoadBlock(cs, k, &b)) {
+      kernels.ordinals(b, z);
+      kernels.weekdays(z, wd);
+      for (std::size_t i = 0; i != k; ++i) out[i] = static_cast<weekday>(wd[i]);
+    } else {
+      for (std::size_t i = 0; i != k; ++i) out[i] = get_weekday(cs[i]);
+    }
+    cs += k;
+    out += k;
+    n -= k;
+  }
+}
+
+template <typename T>
+void DayDifferences(const T* cs, std::size_t n, const civil_day& base,
+                    diff_t* out) {
+  const Kernels& kernels = GetKernels();
+  const bool base_ok = InKernelRange(base.year());
+  const diff_t base_z =
+      base_ok ? kOrdBias + (base - civil_day(1970, 1, 1)) : 0;
+  DateBlock b;
+  std::uint32_t z[kBlockSize];
+  while (n != 0) {
+    const std::size_t k = std::min(n, kBlockSize);
+    if (LoadBlock(cs, k, &b) && base_ok) {
+      kernels.ordinals(b, z);
+      for (std::size_t i = 0; i != k; ++i) out[i] = z[i] - base_z;
+    } else {
+      for (std::size_t i = 0; i != k; ++i) out[i] = civil_day(cs[i]) - base;
+    }
+    cs += k;
+    out += k;
+    n -= k;
+  }
+}
+
+template <typename T>
+void StepDays(const T* cs, std::size_t n, diff_t days, T* out) {
+  const Kernels& kernels = GetKernels();
+  const bool days_ok = -kMaxDays < days && days < kMaxDays;
+  const std::uint32_t step = static_cast<std::uint32_t>(days);  // modular
+  DateBlock b;
+  std::uint32_t z[kBlockSize];
+  while (n != 0) {
+    const std::size_t k = std::min(n, kBlockSize);
+    if (LoadBlock(cs, k, &b) && days_ok) {
+      kernels.ordinals(b, z);
+      for (std::size_t i = 0; i != kBlockSize; ++i) z[i] += step;
+      kernels.dates(z, &b);
+      for (std::size_t i = 0; i != k; ++i) out[i] = MakeDay(b, i, cs[i]);
+    } else {
+      for (std::size_t i = 0; i != k; ++i) out[i] = StepDay(cs[i], days);
+    }
+    cs += k;
+    out += k;
+    n -= k;
+  }
+}
+
+}  // namespace
+
+void get_weekdays(const civil_day* cds, std::size_t n, weekday* out) {
+  GetWeekdays(cds, n, out);
+}
+void get_weekdays(const civil_second* css, std::size_t n, weekday* out) {
+  GetWeekdays(css, n, out);
+}
+
+void day_differences(const civil_day* cds, std::size_t n,
+                     const civil_day& base, diff_t* out) {
+  DayDifferences(cds, n, base, out);
+}
+void day_differences(const civil_second* css, std::size_t n,
+                     const civil_day& base, diff_t* out) {
+  DayDifferences(css, n, base, out);
+}
+
+void step_days(const civil_day* cds, std::size_t n, diff_t days,
+               civil_day* out) {
+  StepDays(cds, n, days, out);
+}
+void step_days(const civil_second* css, std::size_t n, diff_t days,
+               civil_second* out) {
+  StepDays(css, n, days, out);
+}
+
+////////////////////////////////////////////////////////////////////////
+
 // Output stream operators output a format matching YYYY-MM-DDThh:mm:ss,
 // while omitting fields inferior to the type's alignment. For example,
 // civil_day is formatted only as YYYY-MM-DD.
@@ -19,6 +19,7 @@
 #include <sstream>
 #include <string>
 #include <type_traits>
+#include <vector>
 
 #include "gtest/gtest.h"
 
@@ -1051,6 +1052,110 @@ TEST(CivilTime, LeapYears) {
   }
 }
 
+TEST(CivilTime, DayNormalizationMatchesLoop) {
+  using detail::fields;
+  using detail::month_t;
+  const auto same = [](const fields& a, const fields& b) {
+    return a.y == b.y && a.m == b.m && a.d == b.d && a.hh == b.hh &&
+           a.mm == b.mm && a.ss == b.ss;
+  };
+
+  // Every day offset across a 400-year cycle either side of the start of
+  // every month, from years at different points in the cycle.
+  const year_t kYears[] = {-401, -1, 0, 1, 100, 1970};
+  const diff_t kCycle = 146097;
+  for (const year_t y : kYears) {
+    for (int m = 1; m <= 12; ++m) {
+      const month_t mon = static_cast<month_t>(m);
+      for (diff_t d = -kCycle; d <= kCycle; ++d) {
+        const fields f = detail::impl::n_day(y, mon, d, 0, 1, 2, 3);
+        const fields g = detail::impl::n_day_loop(y, mon, d, 0, 1, 2, 3);
+        ASSERT_TRUE(same(f, g)) << y << "-" << m << " + " << d;
+      }
+    }
+  }
+
+  // Days split between the day and carry, including large counts and
+  // years near the ends of the year_t range.
+  const year_t kYearMax = std::numeric_limits<year_t>::max();
+  const year_t kYearMin = std::numeric_limits<year_t>::min();
+  const diff_t kDays[] = {
+      -(diff_t{1} << 61) + 1, -kCycle * 1000000 - 1, -kCycle - 1, -366, -1,
+      0, 1, 28, 29, 366, kCycle + 1, kCycle * 1000000 + 1,
+      (diff_t{1} << 61) - 1};
+  for (const year_t y : {kYearMin + 400 * 100000000000000,
+                         kYearMax - 400 * 100000000000000, year_t{2015}}) {
+    for (int m = 1; m <= 12; ++m) {
+      const month_t mon = static_cast<month_t>(m);
+      for (const diff_t d : kDays) {
+        for (const diff_t cd : kDays) {
+          const fields f = detail::impl::n_day(y, mon, d, cd, 0, 0, 0);
+          const fields g = detail::impl::n_day_loop(y, mon, d, cd, 0, 0, 0);
+          ASSERT_TRUE(same(f, g)) << y << "-" << m << " + " << d << "/" << cd;
+        }
+      }
+    }
+  }
+}
+
+TEST(CivilTime, BatchDayArithmetic) {
+  // A run of days long enough to span several blocks, with a partial
+  // block at the end, and with some years beyond the range of the vector
+  // kernels, which take the scalar path.
+  std::vector<civil_day> cds;
+  for (civil_day cd(1599, 12, 25); cd < civil_day(2401, 1, 1); cd += 13) {
+    cds.push_back(cd);
+  }
+  cds.push_back(civil_day(-1000001, 2, 28));
+  cds.push_back(civil_day(1000001, 3, 1));
+  for (civil_day cd(-400, 2, 20); cd != civil_day(-400, 3, 10); ++cd) {
+    cds.push_back(cd);
+  }
+  std::vector<civil_second> css;
+  for (const civil_day& cd : cds) {
+    css.push_back(civil_second(cd.year(), cd.month(), cd.day(), 23, 59, 58));
+  }
+  const std::size_t n = cds.size();
+
+  std::vector<weekday> wds(n);
+  get_weekdays(cds.data(), n, wds.data());
+  for (std::size_t i = 0; i != n; ++i) {
+    EXPECT_EQ(get_weekday(cds[i]), wds[i]) << cds[i];
+  }
+  get_weekdays(css.data(), n, wds.data());
+  for (std::size_t i = 0; i != n; ++i) {
+    EXPECT_EQ(get_weekday(css[i]), wds[i]) << css[i];
+  }
+
+  std::vector<diff_t> diffs(n);
+  for (const civil_day base : {civil_day(1970, 1, 1), civil_day(2000, 2, 29),
+                               civil_day(-3000000, 1, 1)}) {
+    day_differences(cds.data(), n, base, diffs.data());
+    for (std::size_t i = 0; i != n; ++i) {
+      EXPECT_EQ(cds[i] - base, diffs[i]) << cds[i] << " - " << base;
+    }
+    day_differences(css.data(), n, base, diffs.data());
+    for (std::size_t i = 0; i != n; ++i) {
+      EXPECT_EQ(civil_day(css[i]) - base, diffs[i]) << css[i] << " - " << base;
+    }
+  }
+
+  std::vector<civil_day> cds_out(n);
+  std::vector<civil_second> css_out(n);
+  const diff_t kSteps[] = {0, 1, -1, 59, -366, 146097 * 3 + 17,
+                           -(diff_t{1} << 28) + 1, diff_t{1} << 28};
+  for (const diff_t days : kSteps) {
+    step_days(cds.data(), n, days, cds_out.data());
+    for (std::size_t i = 0; i != n; ++i) {
+      EXPECT_EQ(cds[i] + days, cds_out[i]) << cds[i] << " + " << days;
+    }
+    step_days(css.data(), n, days, css_out.data());
+    for (std::size_t i = 0; i != n; ++i) {
+      EXPECT_EQ(css[i] + days * 86400, css_out[i]) << css[i] << " + " << days;
+    }
+  }
+}
+
 TEST(CivilTime, FirstThursdayInMonth) {
   const civil_day nov1(2014, 11, 1);
   const civil_day thursday = next_weekday(nov1 - 1, weekday::thursday);
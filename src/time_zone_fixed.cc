@@ -47,6 +47,49 @@ int Parse02d(const char* p) {
 
 }  // namespace
 
+TimeZoneFixed::TimeZoneFixed(const seconds& offset)
+    : utc_offset_(static_cast<std::int_least32_t>(offset.count())),
+      abbr_(FixedOffsetToAbbr(offset)),
+      civil_max_(UnixToCivil(seconds::max().count(), utc_offset_)),
+      civil_min_(UnixToCivil(seconds::min().count(), utc_offset_)) {}
+
+void TimeZoneFixed::BreakTimes(const time_point<seconds>* tps, std::size_t n,
+                               time_zone::absolute_lookup* als) const {
+  for (std::size_t i = 0; i != n; ++i) als[i] = BreakTime(tps[i]);
+}
+
+// The offset never changes, so the span is everything.
+time_zone::absolute_lookup TimeZoneFixed::BreakTimeSpan(
+    const time_point<seconds>& tp, std::size_t* /*hint*/,
+    time_point<seconds>* first, time_point<seconds>* last) const {
+  *first = time_point<seconds>::min();
+  *last = time_point<seconds>::max();
+  return BreakTime(tp);
+}
+
+void TimeZoneFixed::MakeTimes(const civil_second* cs, std::size_t n,
+                              time_zone::civil_lookup* cls) const {
+  for (std::size_t i = 0; i != n; ++i) cls[i] = MakeTime(cs[i]);
+}
+
+bool TimeZoneFixed::NextTransition(const time_point<seconds>&,
+                                   time_zone::civil_transition*) const {
+  return false;
+}
+
+bool TimeZoneFixed::PrevTransition(const time_point<seconds>&,
+                                   time_zone::civil_transition*) const {
+  return false;
+}
+
+std::string TimeZoneFixed::Version() const {
+  return std::string();  // not from the tz database
+}
+
+std::string TimeZoneFixed::Description() const {
+  return FixedOffsetToName(seconds(utc_offset_));
+}
+
 bool FixedOffsetFromName(const std::string& name, seconds* offset) {
   if (name == "UTC" || name == "UTC0") {
     *offset = seconds::zero();
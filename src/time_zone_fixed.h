@@ -15,9 +15,13 @@
 #ifndef CCTZ_TIME_ZONE_FIXED_H_
 #define CCTZ_TIME_ZONE_FIXED_H_
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
+#include "cctz/civil_time.h"
 #include "cctz/time_zone.h"
+#include "time_zone_if.h"
 
 namespace cctz {
 
@@ -40,6 +44,61 @@ bool FixedOffsetFromName(const std::string& name, seconds* offset);
 std::string FixedOffsetToName(const seconds& offset);
 std::string FixedOffsetToAbbr(const seconds& offset);
 
+// A time zone that is a fixed offset from UTC (including UTC itself), for
+// which conversions are simple arithmetic. TimeZoneIf::Load() uses this for
+// all fixed-offset names, and, as the class is final, time_zone::Impl can
+// make non-virtual (and inlined) calls to BreakTime() and MakeTime().
+class TimeZoneFixed final : public TimeZoneIf {
+ public:
+  explicit TimeZoneFixed(const seconds& offset);
+
+  // TimeZoneIf implementations.
+  time_zone::absolute_lookup BreakTime(
+      const time_point<seconds>& tp) const override {
+    return {UnixToCivil(ToUnixSeconds(tp), utc_offset_), utc_offset_, false,
+            abbr_.c_str()};
+  }
+  void BreakTimes(const time_point<seconds>* tps, std::size_t n,
+                  time_zone::absolute_lookup* als) const override;
+  time_zone::absolute_lookup BreakTimeSpan(
+      const time_point<seconds>& tp, std::size_t* hint,
+      time_point<seconds>* first, time_point<seconds>* last) const override;
+  time_zone::civil_lookup MakeTime(const civil_second& cs) const override {
+    time_zone::civil_lookup cl;
+    cl.kind = time_zone::civil_lookup::UNIQUE;
+    const year_t year = cs.year();
+    if (-kSafeYears < year && year < kSafeYears) {
+      cl.pre = FromUnixSeconds((cs - civil_second()) - utc_offset_);
+    } else if (cs > civil_max_) {
+      cl.pre = time_point<seconds>::max();
+    } else if (cs < civil_min_) {
+      cl.pre = time_point<seconds>::min();
+    } else {
+      cl.pre = FromUnixSeconds(cs - (civil_second() + utc_offset_));
+    }
+    cl.trans = cl.post = cl.pre;
+    return cl;
+  }
+  void MakeTimes(const civil_second* cs, std::size_t n,
+                 time_zone::civil_lookup* cls) const override;
+  bool NextTransition(const time_point<seconds>& tp,
+                      time_zone::civil_transition* trans) const override;
+  bool PrevTransition(const time_point<seconds>& tp,
+                      time_zone::civil_transition* trans) const override;
+  std::string Version() const override;
+  std::string Description() const override;
+
+ private:
+  // Within this many years of 0 (or 1970) the seconds since the epoch are
+  // well clear of overflow, so MakeTime() need not check the limits.
+  static constexpr year_t kSafeYears = 290000000000;
+
+  const std::int_least32_t utc_offset_;
+  const std::string abbr_;
+  const civil_second civil_max_;  // max convertible civil time
+  const civil_second civil_min_;  // min convertible civil time
+};
+
 }  // namespace cctz
 
 #endif  // CCTZ_TIME_ZONE_FIXED_H_
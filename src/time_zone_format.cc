@@ -30,7 +30,9 @@
 // declare strptime.
 #include <time.h>
 
+#include <algorithm>
 #include <cctype>
+#include <clocale>
 #include <chrono>
 #include <cstddef>
 #include <cstdint>
@@ -38,6 +40,7 @@
 #include <ctime>
 #include <limits>
 #include <string>
+#include <utility>
 #include <vector>
 #if !HAS_STRPTIME
 #include <iomanip>
@@ -135,8 +138,26 @@ int ToWeek(const civil_day& cd, weekday week_start) {
   return static_cast<int>((d - prev_weekday(civil_year(d), week_start)) / 7);
 }
 
+// The names of days (indexed by tm_wday) and months in the "C" locale.
+const char* const kWeekdayNames[] = {
+    "Sunday",   "Monday", "Tuesday", "Wednesday",
+    "Thursday", "Friday", "Saturday",
+};
+const char* const kMonthNames[] = {
+    "January", "February", "March",     "April",   "May",      "June",
+    "July",    "August",   "September", "October", "November", "December",
+};
+
 const char kDigits[] = "0123456789";
 
+// The %02d representations of [0 .. 99], so that digits can be produced in
+// pairs.
+const char kDigitPairs[] =
+    "00010203040506070809101112131415161718192021222324"
+    "25262728293031323334353637383940414243444546474849"
+    "50515253545556575859606162636465666768697071727374"
+    "75767778798081828384858687888990919293949596979899";
+
 // Formats a 64-bit integer in the given field width.  Note that it is up
 // to the caller of Format64() [and Format02d()/FormatOffset()] to ensure
 // that there is sufficient space before ep to hold the conversion.
@@ -158,10 +179,19 @@ char* Format64(char* ep, int width, std::int_fast64_t v) {
     }
     v = -v;
   }
-  do {
-    --width;
-    *--ep = kDigits[v % 10];
-  } while (v /= 10);
+  char* const dp = ep;
+  while (v >= 100) {
+    ep -= 2;
+    std::memcpy(ep, &kDigitPairs[2 * (v % 100)], 2);
+    v /= 100;
+  }
+  if (v >= 10) {
+    ep -= 2;
+    std::memcpy(ep, &kDigitPairs[2 * v], 2);
+  } else {
+    *--ep = kDigits[v];
+  }
+  width -= static_cast<int>(dp - ep);
   while (--width >= 0) *--ep = '0';  // zero pad
   if (neg) *--ep = '-';
   return ep;
@@ -169,11 +199,34 @@ char* Format64(char* ep, int width, std::int_fast64_t v) {
 
 // Formats [0 .. 99] as %02d.
 char* Format02d(char* ep, int v) {
-  *--ep = kDigits[v % 10];
-  *--ep = kDigits[(v / 10) % 10];
+  ep -= 2;
+  std::memcpy(ep, &kDigitPairs[2 * v], 2);
   return ep;
 }
 
+// Formats the date of a civil_second as %Y-%m-%d, the time as %H:%M:%S,
+// or both, separated by sep, so that a whole timestamp is written with a
+// few stores, rather than by a field at a time.
+char* FormatDate(char* ep, const civil_second& cs) {
+  ep = Format02d(ep, cs.day());
+  *--ep = '-';
+  ep = Format02d(ep, cs.month());
+  *--ep = '-';
+  return Format64(ep, 0, cs.year());
+}
+char* FormatTime(char* ep, const civil_second& cs) {
+  ep = Format02d(ep, cs.second());
+  *--ep = ':';
+  ep = Format02d(ep, cs.minute());
+  *--ep = ':';
+  return Format02d(ep, cs.hour());
+}
+char* FormatDateTime(char* ep, const civil_second& cs, char sep) {
+  ep = FormatTime(ep, cs);
+  *--ep = sep;
+  return FormatDate(ep, cs);
+}
+
 // Formats a UTC offset, like +00:00.
 char* FormatOffset(char* ep, int offset, const char* mode) {
   // TODO: Follow the RFC3339 "Unknown Local Offset Convention" and
@@ -207,71 +260,197 @@ char* FormatOffset(char* ep, int offset, const char* mode) {
   return ep;
 }
 
-// Formats a std::tm using strftime(3).
-void FormatTM(std::string* out, const std::string& fmt, const std::tm& tm) {
+// The destination of formatted output: either a string, which is appended
+// to, or a caller's buffer, which receives as much of the output as fits.
+// Either way, size() is the full length of the output.
+class FormatOutput {
+ public:
+  explicit FormatOutput(std::string* str)
+      : str_(str), buf_(nullptr), cap_(0), len_(0) {}
+  FormatOutput(char* buf, std::size_t cap)
+      : str_(nullptr), buf_(buf), cap_(cap), len_(0) {}
+
+  void append(const char* p, std::size_t n) {
+    if (str_ != nullptr) {
+      str_->append(p, n);
+    } else if (len_ < cap_) {
+      std::memcpy(buf_ + len_, p, std::min(n, cap_ - len_));
+    }
+    len_ += n;
+  }
+  void append(const char* s) { append(s, std::strlen(s)); }
+  void append(const std::string& s) { append(s.data(), s.size()); }
+
+  std::size_t size() const { return len_; }
+
+ private:
+  std::string* str_;
+  char* buf_;
+  std::size_t cap_;
+  std::size_t len_;
+};
+
+// Formats a std::tm using strftime(3), given the NUL-terminated format and
+// its length.
+void FormatTM(FormatOutput* out, const char* fmt, std::size_t fmt_size,
+              const std::tm& tm) {
   // strftime(3) returns the number of characters placed in the output
   // array (which may be 0 characters).  It also returns 0 to indicate
   // an error, like the array wasn't large enough.  To accommodate this,
   // the following code grows the buffer size from 2x the format string
-  // length up to 32x.
+  // length up to 32x.  Only unusually long results use the heap.
+  char stack_buf[256];
+  std::vector<char> heap_buf;
   for (std::size_t i = 2; i != 32; i *= 2) {
-    std::size_t buf_size = fmt.size() * i;
-    std::vector<char> buf(buf_size);
-    if (std::size_t len = strftime(&buf[0], buf_size, fmt.c_str(), &tm)) {
-      out->append(&buf[0], len);
+    std::size_t buf_size = fmt_size * i;
+    char* buf = stack_buf;
+    if (buf_size > sizeof(stack_buf)) {
+      heap_buf.resize(buf_size);
+      buf = &heap_buf[0];
+    }
+    if (std::size_t len = strftime(buf, buf_size, fmt, &tm)) {
+      out->append(buf, len);
       return;
     }
   }
 }
 
+// As above, but given a format that is not NUL-terminated, which is copied
+// to the stack unless it is unusually long.
+void FormatTM(FormatOutput* out, const char* p, const char* ep,
+              const std::tm& tm) {
+  const std::size_t fmt_size = static_cast<std::size_t>(ep - p);
+  char fmt_buf[64];
+  if (fmt_size < sizeof(fmt_buf)) {
+    std::memcpy(fmt_buf, p, fmt_size);
+    fmt_buf[fmt_size] = '\0';
+    FormatTM(out, fmt_buf, fmt_size, tm);
+  } else {
+    const std::string fmt(p, ep);
+    FormatTM(out, fmt.c_str(), fmt_size, tm);
+  }
+}
+
+// Returns the length of the run of digits at dp, stopping after max of them
+// when max > 0.
+int DigitRun(const char* dp, int max) {
+  int n = 0;
+  while (static_cast<unsigned char>(dp[n]) - unsigned{'0'} <= 9) {
+    if (++n == max) break;
+  }
+  return n;
+}
+
+// Loads the 8 (or 4) characters at dp, the first into the least-significant
+// byte.
+std::uint_fast64_t Load8(const char* dp) {
+  std::uint64_t v;
+  std::memcpy(&v, dp, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  v = __builtin_bswap64(v);
+#endif
+  return v;
+}
+std::uint_fast32_t Load4(const char* dp) {
+  std::uint32_t v;
+  std::memcpy(&v, dp, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  v = __builtin_bswap32(v);
+#endif
+  return v;
+}
+
+// Returns the value of the n digits at dp, which must all be digits, or
+// false if it exceeds limit. Runs of 8, 4 and 2 digits are converted using
+// SWAR, where each step combines adjacent digits (or groups of digits) in
+// every lane at once.
+bool ParseDigits(const char* dp, int n, std::uint_fast64_t limit,
+                 std::uint_fast64_t* vp) {
+  std::uint_fast64_t value = 0;
+  for (; n >= 8; n -= 8, dp += 8) {
+    std::uint_fast64_t v = Load8(dp) - 0x3030303030303030;
+    v = (v * 10 + (v >> 8)) & 0x00FF00FF00FF00FF;
+    v = (v * 100 + (v >> 16)) & 0x0000FFFF0000FFFF;
+    v = (v * 10000 + (v >> 32)) & 0x00000000FFFFFFFF;
+    if (value > (limit - std::min(v, limit)) / 100000000) return false;
+    value = value * 100000000 + v;
+  }
+  if (n >= 4) {
+    std::uint_fast64_t v = Load4(dp) - 0x30303030;
+    v = (v * 10 + (v >> 8)) & 0x00FF00FF;
+    v = (v * 100 + (v >> 16)) & 0x0000FFFF;
+    if (value > (limit - std::min(v, limit)) / 10000) return false;
+    value = value * 10000 + v;
+    n -= 4;
+    dp += 4;
+  }
+  if (n >= 2) {
+    const std::uint_fast64_t v = static_cast<std::uint_fast64_t>(
+        (dp[0] - '0') * 10 + (dp[1] - '0'));
+    if (value > (limit - std::min(v, limit)) / 100) return false;
+    value = value * 100 + v;
+    n -= 2;
+    dp += 2;
+  }
+  if (n != 0) {
+    const std::uint_fast64_t v = static_cast<std::uint_fast64_t>(dp[0] - '0');
+    if (value > (limit - std::min(v, limit)) / 10) return false;
+    value = value * 10 + v;
+  }
+  if (value > limit) return false;
+  *vp = value;
+  return true;
+}
+
 // Used for %E#S/%E#f specifiers and for data values in parse().
 template <typename T>
 const char* ParseInt(const char* dp, int width, T min, T max, T* vp) {
   if (dp != nullptr) {
-    const T kmin = std::numeric_limits<T>::min();
-    bool erange = false;
     bool neg = false;
-    T value = 0;
     if (*dp == '-') {
       neg = true;
       if (width <= 0 || --width != 0) {
         ++dp;
       } else {
-        dp = nullptr;  // width was 1
+        return nullptr;  // width was 1
       }
     }
-    if (const char* const bp = dp) {
-      while (const char* cp = strchr(kDigits, *dp)) {
-        int d = static_cast<int>(cp - kDigits);
-        if (d >= 10) break;
-        if (value < kmin / 10) {
-          erange = true;
-          break;
-        }
-        value *= 10;
-        if (value < kmin + d) {
-          erange = true;
-          break;
-        }
-        value -= d;
-        dp += 1;
-        if (width > 0 && --width == 0) break;
-      }
-      if (dp != bp && !erange && (neg || value != kmin)) {
-        if (!neg || value != 0) {
-          if (!neg) value = -value;  // make positive
-          if (min <= value && value <= max) {
-            *vp = value;
-          } else {
-            dp = nullptr;
-          }
-        } else {
-          dp = nullptr;
-        }
-      } else {
-        dp = nullptr;
-      }
+    // The magnitude of the value may be up to that of the minimum when it
+    // is negative, or of the maximum otherwise.
+    const std::uint_fast64_t kmax =
+        static_cast<std::uint_fast64_t>(std::numeric_limits<T>::max());
+    const int n = DigitRun(dp, width);
+    std::uint_fast64_t magnitude;
+    if (n == 0 || !ParseDigits(dp, n, neg ? kmax + 1 : kmax, &magnitude)) {
+      return nullptr;
     }
+    if (neg && magnitude == 0) return nullptr;  // "-0"
+    const T value = neg ? static_cast<T>(-static_cast<T>(magnitude - 1) - 1)
+                        : static_cast<T>(magnitude);
+    if (value < min || max < value) return nullptr;
+    *vp = value;
+    dp += n;
+  }
+  return dp;
+}
+
+// Equivalent to ParseInt(dp, 2, min, max, vp) when 0 <= min, but only
+// needs to look at two characters. (A leading '-' can never produce a
+// value in range, so it always fails.)
+const char* ParseInt2(const char* dp, int min, int max, int* vp) {
+  if (dp != nullptr) {
+    const unsigned d0 = static_cast<unsigned char>(dp[0]) - unsigned{'0'};
+    if (d0 > 9) return nullptr;
+    int value = static_cast<int>(d0);
+    const unsigned d1 = static_cast<unsigned char>(dp[1]) - unsigned{'0'};
+    if (d1 <= 9) {
+      value = value * 10 + static_cast<int>(d1);
+      dp += 2;
+    } else {
+      dp += 1;
+    }
+    if (value < min || max < value) return nullptr;
+    *vp = value;
   }
   return dp;
 }
@@ -303,43 +482,57 @@ const std::int_fast64_t kExp10[kDigits10_64 + 1] = {
     1000000000000000000,
 };
 
-}  // namespace
-
-// Uses strftime(3) to format the given Time.  The following extended format
-// specifiers are also supported:
-//
-//   - %Ez  - RFC3339-compatible numeric UTC offset (+hh:mm or -hh:mm)
-//   - %E*z - Full-resolution numeric UTC offset (+hh:mm:ss or -hh:mm:ss)
-//   - %E#S - Seconds with # digits of fractional precision
-//   - %E*S - Seconds with full fractional precision (a literal '*')
-//   - %E4Y - Four-character years (-999 ... -001, 0000, 0001 ... 9999)
-//   - %ET  - The RFC3339 "date-time" separator "T"
-//
-// The standard specifiers from RFC3339_* (%Y, %m, %d, %H, %M, and %S) are
-// handled internally for performance reasons.  strftime(3) is slow due to
-// a POSIX requirement to respect changes to ${TZ}.
-//
-// The TZ/GNU %s extension is handled internally because strftime() has
-// to use mktime() to generate it, and that assumes the local time zone.
-//
-// We also handle the %z and %Z specifiers to accommodate platforms that do
-// not support the tm_gmtoff and tm_zone extensions to std::tm.
-//
-// Requires that zero() <= fs < seconds(1).
-std::string format(const std::string& format, const time_point<seconds>& tp,
-                   const detail::femtoseconds& fs, const time_zone& tz) {
-  std::string result;
-  result.reserve(format.size());  // A reasonable guess for the result size.
-  const time_zone::absolute_lookup al = tz.lookup(tp);
-  const std::tm tm = ToTM(al);
-
-  // Scratch buffer for internal conversions.
-  char buf[3 + kDigits10_64];  // enough for longest conversion
-  char* const ep = buf + sizeof(buf);
-  char* bp;  // works back from ep
+// The fields of a format that we handle ourselves. These are the kinds of
+// the operations in a format_plan, along with kLiteral for text that is
+// copied out as is, and kStrftime for text that is formatted by strftime().
+enum FormatKind : std::uint_least8_t {
+  kLiteral,
+  kStrftime,
+  kYear,             // %Y
+  kYear4,            // %E4Y
+  kMonth,            // %m
+  kDay,              // %d
+  kDaySpace,         // %e
+  kWeekSunday,       // %U
+  kWeekdayMonday1,   // %u
+  kWeekMonday,       // %W
+  kWeekdaySunday0,   // %w
+  kHour,             // %H
+  kMinute,           // %M
+  kSecond,           // %S
+  kOffset,           // %z
+  kOffsetColon,      // %:z and %Ez
+  kOffsetFull,       // %::z and %E*z
+  kOffsetMinimal,    // %:::z
+  kAbbr,             // %Z
+  kUnixSeconds,      // %s
+  kSecondsFull,      // %E*S
+  kSubsecondsFull,   // %E*f
+  kSecondsN,         // %E#S
+  kSubsecondsN,      // %E#f
+  kYear2,            // %y
+  kYearDay,          // %j
+  kWeekdayName,      // %a
+  kWeekdayFullName,  // %A
+  kMonthName,        // %b and %h
+  kMonthFullName,    // %B
+  kAmPm,             // %p
+  kDate,             // %F and %Y-%m-%d
+  kTime,             // %T and %H:%M:%S
+  kRFC3339Full,      // the whole of RFC3339_full
+  kRFC3339Sec,       // the whole of RFC3339_sec
+};
 
+// Scans a format string, reporting the literal text, the text to format
+// with strftime(), and the fields that we handle ourselves to the sink,
+// in order. This is the format() parser, which a format_plan also uses to
+// record its operations. The names of days and months, and the AM/PM
+// designation, are those of the "C" locale unless locale_aware is set, in
+// which case they are left to strftime() and so follow the LC_TIME locale.
+template <typename Sink>
+void ScanFormat(const std::string& format, bool locale_aware, Sink* sink) {
   // Maintain three, disjoint subsequences that span format.
-  //   [format.begin() ... pending) : already formatted into result
+  //   [format.begin() ... pending) : already reported to the sink
   //   [pending ... cur) : formatting pending, but no special cases
   //   [cur ... format.end()) : unexamined
   // Initially, everything is in the unexamined part.
@@ -354,7 +547,7 @@ std::string format(const std::string& format, const time_point<seconds>& tp,
 
     // If the new pending text is all ordinary, copy it out.
     if (cur != start && pending == start) {
-      result.append(pending, static_cast<std::size_t>(cur - pending));
+      sink->Literal(pending, static_cast<std::size_t>(cur - pending));
       pending = start = cur;
     }
 
@@ -366,11 +559,11 @@ std::string format(const std::string& format, const time_point<seconds>& tp,
     // percent for every matched pair, then skip those pairs.
     if (cur != start && pending == start) {
       std::size_t escaped = static_cast<std::size_t>(cur - pending) / 2;
-      result.append(pending, escaped);
+      sink->Literal(pending, escaped);
       pending += escaped * 2;
       // Also copy out a single trailing percent.
       if (pending != cur && cur == end) {
-        result.push_back(*pending++);
+        sink->Literal(pending++, 1);
       }
     }
 
@@ -378,68 +571,108 @@ std::string format(const std::string& format, const time_point<seconds>& tp,
     if (cur == end || (cur - percent) % 2 == 0) continue;
 
     // Simple specifiers that we handle ourselves.
-    if (strchr("YmdeUuWwHMSzZs%", *cur)) {
+    if (strchr("YmdeUuWwHMSzZs%yjDFRT", *cur) ||
+        (!locale_aware && strchr("aAbhBp", *cur))) {
       if (cur - 1 != pending) {
-        FormatTM(&result, std::string(pending, cur - 1), tm);
+        sink->Strftime(pending, cur - 1);
       }
       switch (*cur) {
         case 'Y':
           // This avoids the tm.tm_year overflow problem for %Y, however
-          // tm.tm_year will still be used by other specifiers like %D.
-          bp = Format64(ep, 0, al.cs.year());
-          result.append(bp, static_cast<std::size_t>(ep - bp));
+          // tm.tm_year will still be used by other specifiers like %c and %G.
+          if (end - cur >= 7 && std::memcmp(cur, "Y-%m-%d", 7) == 0) {
+            sink->Field(kDate, 0);
+            cur += 6;
+          } else {
+            sink->Field(kYear, 0);
+          }
           break;
         case 'm':
-          bp = Format02d(ep, al.cs.month());
-          result.append(bp, static_cast<std::size_t>(ep - bp));
+          sink->Field(kMonth, 0);
           break;
         case 'd':
+          sink->Field(kDay, 0);
+          break;
         case 'e':
-          bp = Format02d(ep, al.cs.day());
-          if (*cur == 'e' && *bp == '0') *bp = ' ';  // for Windows
-          result.append(bp, static_cast<std::size_t>(ep - bp));
+          sink->Field(kDaySpace, 0);
           break;
         case 'U':
-          bp = Format02d(ep, ToWeek(civil_day(al.cs), weekday::sunday));
-          result.append(bp, static_cast<std::size_t>(ep - bp));
+          sink->Field(kWeekSunday, 0);
           break;
         case 'u':
-          bp = Format64(ep, 0, tm.tm_wday ? tm.tm_wday : 7);
-          result.append(bp, static_cast<std::size_t>(ep - bp));
+          sink->Field(kWeekdayMonday1, 0);
           break;
         case 'W':
-          bp = Format02d(ep, ToWeek(civil_day(al.cs), weekday::monday));
-          result.append(bp, static_cast<std::size_t>(ep - bp));
+          sink->Field(kWeekMonday, 0);
           break;
         case 'w':
-          bp = Format64(ep, 0, tm.tm_wday);
-          result.append(bp, static_cast<std::size_t>(ep - bp));
+          sink->Field(kWeekdaySunday0, 0);
           break;
         case 'H':
-          bp = Format02d(ep, al.cs.hour());
-          result.append(bp, static_cast<std::size_t>(ep - bp));
+          if (end - cur >= 7 && std::memcmp(cur, "H:%M:%S", 7) == 0) {
+            sink->Field(kTime, 0);
+            cur += 6;
+          } else {
+            sink->Field(kHour, 0);
+          }
           break;
         case 'M':
-          bp = Format02d(ep, al.cs.minute());
-          result.append(bp, static_cast<std::size_t>(ep - bp));
+          sink->Field(kMinute, 0);
           break;
         case 'S':
-          bp = Format02d(ep, al.cs.second());
-          result.append(bp, static_cast<std::size_t>(ep - bp));
+          sink->Field(kSecond, 0);
           break;
         case 'z':
-          bp = FormatOffset(ep, al.offset, "");
-          result.append(bp, static_cast<std::size_t>(ep - bp));
+          sink->Field(kOffset, 0);
           break;
         case 'Z':
-          result.append(al.abbr);
+          sink->Field(kAbbr, 0);
           break;
         case 's':
-          bp = Format64(ep, 0, ToUnixSeconds(tp));
-          result.append(bp, static_cast<std::size_t>(ep - bp));
+          sink->Field(kUnixSeconds, 0);
           break;
         case '%':
-          result.push_back('%');
+          sink->Literal(cur, 1);
+          break;
+        case 'y':
+          sink->Field(kYear2, 0);
+          break;
+        case 'j':
+          sink->Field(kYearDay, 0);
+          break;
+        case 'D':
+          sink->Field(kMonth, 0);
+          sink->Literal("/", 1);
+          sink->Field(kDay, 0);
+          sink->Literal("/", 1);
+          sink->Field(kYear2, 0);
+          break;
+        case 'F':
+          sink->Field(kDate, 0);
+          break;
+        case 'R':
+          sink->Field(kHour, 0);
+          sink->Literal(":", 1);
+          sink->Field(kMinute, 0);
+          break;
+        case 'T':
+          sink->Field(kTime, 0);
+          break;
+        case 'a':
+          sink->Field(kWeekdayName, 0);
+          break;
+        case 'A':
+          sink->Field(kWeekdayFullName, 0);
+          break;
+        case 'b':
+        case 'h':
+          sink->Field(kMonthName, 0);
+          break;
+        case 'B':
+          sink->Field(kMonthFullName, 0);
+          break;
+        case 'p':
+          sink->Field(kAmPm, 0);
           break;
       }
       pending = ++cur;
@@ -451,10 +684,9 @@ std::string format(const std::string& format, const time_point<seconds>& tp,
       if (*(cur + 1) == 'z') {
         // Formats %:z.
         if (cur - 1 != pending) {
-          FormatTM(&result, std::string(pending, cur - 1), tm);
+          sink->Strftime(pending, cur - 1);
         }
-        bp = FormatOffset(ep, al.offset, ":");
-        result.append(bp, static_cast<std::size_t>(ep - bp));
+        sink->Field(kOffsetColon, 0);
         pending = cur += 2;
         continue;
       }
@@ -462,10 +694,9 @@ std::string format(const std::string& format, const time_point<seconds>& tp,
         if (*(cur + 2) == 'z') {
           // Formats %::z.
           if (cur - 1 != pending) {
-            FormatTM(&result, std::string(pending, cur - 1), tm);
+            sink->Strftime(pending, cur - 1);
           }
-          bp = FormatOffset(ep, al.offset, ":*");
-          result.append(bp, static_cast<std::size_t>(ep - bp));
+          sink->Field(kOffsetFull, 0);
           pending = cur += 3;
           continue;
         }
@@ -473,10 +704,9 @@ std::string format(const std::string& format, const time_point<seconds>& tp,
           if (*(cur + 3) == 'z') {
             // Formats %:::z.
             if (cur - 1 != pending) {
-              FormatTM(&result, std::string(pending, cur - 1), tm);
+              sink->Strftime(pending, cur - 1);
             }
-            bp = FormatOffset(ep, al.offset, ":*:");
-            result.append(bp, static_cast<std::size_t>(ep - bp));
+            sink->Field(kOffsetMinimal, 0);
             pending = cur += 4;
             continue;
           }
@@ -491,53 +721,38 @@ std::string format(const std::string& format, const time_point<seconds>& tp,
     if (*cur == 'T') {
       // Formats %ET.
       if (cur - 2 != pending) {
-        FormatTM(&result, std::string(pending, cur - 2), tm);
+        sink->Strftime(pending, cur - 2);
       }
-      result.append("T");
+      sink->Literal(cur, 1);
       pending = ++cur;
     } else if (*cur == 'z') {
       // Formats %Ez.
       if (cur - 2 != pending) {
-        FormatTM(&result, std::string(pending, cur - 2), tm);
+        sink->Strftime(pending, cur - 2);
       }
-      bp = FormatOffset(ep, al.offset, ":");
-      result.append(bp, static_cast<std::size_t>(ep - bp));
+      sink->Field(kOffsetColon, 0);
       pending = ++cur;
     } else if (*cur == '*' && cur + 1 != end && *(cur + 1) == 'z') {
       // Formats %E*z.
       if (cur - 2 != pending) {
-        FormatTM(&result, std::string(pending, cur - 2), tm);
+        sink->Strftime(pending, cur - 2);
       }
-      bp = FormatOffset(ep, al.offset, ":*");
-      result.append(bp, static_cast<std::size_t>(ep - bp));
+      sink->Field(kOffsetFull, 0);
       pending = cur += 2;
     } else if (*cur == '*' && cur + 1 != end &&
                (*(cur + 1) == 'S' || *(cur + 1) == 'f')) {
       // Formats %E*S or %E*F.
       if (cur - 2 != pending) {
-        FormatTM(&result, std::string(pending, cur - 2), tm);
-      }
-      char* cp = ep;
-      bp = Format64(cp, 15, fs.count());
-      while (cp != bp && cp[-1] == '0') --cp;
-      switch (*(cur + 1)) {
-        case 'S':
-          if (cp != bp) *--bp = '.';
-          bp = Format02d(bp, al.cs.second());
-          break;
-        case 'f':
-          if (cp == bp) *--bp = '0';
-          break;
+        sink->Strftime(pending, cur - 2);
       }
-      result.append(bp, static_cast<std::size_t>(cp - bp));
+      sink->Field(*(cur + 1) == 'S' ? kSecondsFull : kSubsecondsFull, 0);
       pending = cur += 2;
     } else if (*cur == '4' && cur + 1 != end && *(cur + 1) == 'Y') {
       // Formats %E4Y.
       if (cur - 2 != pending) {
-        FormatTM(&result, std::string(pending, cur - 2), tm);
+        sink->Strftime(pending, cur - 2);
       }
-      bp = Format64(ep, 4, al.cs.year());
-      result.append(bp, static_cast<std::size_t>(ep - bp));
+      sink->Field(kYear4, 0);
       pending = cur += 2;
     } else if (std::isdigit(*cur)) {
       // Possibly found %E#S or %E#f.
@@ -546,17 +761,10 @@ std::string format(const std::string& format, const time_point<seconds>& tp,
         if (*np == 'S' || *np == 'f') {
           // Formats %E#S or %E#f.
           if (cur - 2 != pending) {
-            FormatTM(&result, std::string(pending, cur - 2), tm);
-          }
-          bp = ep;
-          if (n > 0) {
-            if (n > kDigits10_64) n = kDigits10_64;
-            bp = Format64(bp, n, (n > 15) ? fs.count() * kExp10[n - 15]
-                                          : fs.count() / kExp10[15 - n]);
-            if (*np == 'S') *--bp = '.';
+            sink->Strftime(pending, cur - 2);
           }
-          if (*np == 'S') bp = Format02d(bp, al.cs.second());
-          result.append(bp, static_cast<std::size_t>(ep - bp));
+          if (n > kDigits10_64) n = kDigits10_64;
+          sink->Field(*np == 'S' ? kSecondsN : kSubsecondsN, n);
           pending = cur = ++np;
         }
       }
@@ -565,12 +773,441 @@ std::string format(const std::string& format, const time_point<seconds>& tp,
 
   // Formats any remaining data.
   if (end != pending) {
-    FormatTM(&result, std::string(pending, end), tm);
+    sink->Strftime(pending, end);
+  }
+}
+
+// Appends the formatted field to the result.
+void FormatField(FormatOutput* result, FormatKind kind, int n,
+                 const time_zone::absolute_lookup& al,
+                 const time_point<seconds>& tp,
+                 const detail::femtoseconds& fs) {
+  // Scratch buffer for internal conversions.
+  char buf[(2 + kDigits10_64) + 6];  // enough for longest conversion (%F)
+  char* const ep = buf + sizeof(buf);
+  char* bp = ep;  // works back from ep
+  char* cp = ep;  // the end of the conversion
+  switch (kind) {
+    case kLiteral:
+    case kStrftime:
+    case kRFC3339Full:
+    case kRFC3339Sec:
+      break;
+    case kYear:
+      bp = Format64(ep, 0, al.cs.year());
+      break;
+    case kYear4:
+      bp = Format64(ep, 4, al.cs.year());
+      break;
+    case kMonth:
+      bp = Format02d(ep, al.cs.month());
+      break;
+    case kDay:
+      bp = Format02d(ep, al.cs.day());
+      break;
+    case kDaySpace:
+      bp = Format02d(ep, al.cs.day());
+      if (*bp == '0') *bp = ' ';  // for Windows
+      break;
+    case kWeekSunday:
+      bp = Format02d(ep, ToWeek(civil_day(al.cs), weekday::sunday));
+      break;
+    case kWeekdayMonday1: {
+      const int wday = ToTmWday(get_weekday(al.cs));
+      bp = Format64(ep, 0, wday ? wday : 7);
+      break;
+    }
+    case kWeekMonday:
+      bp = Format02d(ep, ToWeek(civil_day(al.cs), weekday::monday));
+      break;
+    case kWeekdaySunday0:
+      bp = Format64(ep, 0, ToTmWday(get_weekday(al.cs)));
+      break;
+    case kDate:
+      bp = FormatDate(ep, al.cs);
+      break;
+    case kTime:
+      bp = FormatTime(ep, al.cs);
+      break;
+    case kHour:
+      bp = Format02d(ep, al.cs.hour());
+      break;
+    case kMinute:
+      bp = Format02d(ep, al.cs.minute());
+      break;
+    case kSecond:
+      bp = Format02d(ep, al.cs.second());
+      break;
+    case kOffset:
+      bp = FormatOffset(ep, al.offset, "");
+      break;
+    case kOffsetColon:
+      bp = FormatOffset(ep, al.offset, ":");
+      break;
+    case kOffsetFull:
+      bp = FormatOffset(ep, al.offset, ":*");
+      break;
+    case kOffsetMinimal:
+      bp = FormatOffset(ep, al.offset, ":*:");
+      break;
+    case kAbbr:
+      result->append(al.abbr);
+      break;
+    case kYear2:
+      bp = Format02d(ep, static_cast<int>((al.cs.year() % 100 + 100) % 100));
+      break;
+    case kYearDay:
+      bp = Format64(ep, 3, get_yearday(al.cs));
+      break;
+    case kWeekdayName:
+      result->append(kWeekdayNames[ToTmWday(get_weekday(al.cs))], 3);
+      break;
+    case kWeekdayFullName:
+      result->append(kWeekdayNames[ToTmWday(get_weekday(al.cs))]);
+      break;
+    case kMonthName:
+      result->append(kMonthNames[al.cs.month() - 1], 3);
+      break;
+    case kMonthFullName:
+      result->append(kMonthNames[al.cs.month() - 1]);
+      break;
+    case kAmPm:
+      result->append(al.cs.hour() < 12 ? "AM" : "PM", 2);
+      break;
+    case kUnixSeconds:
+      bp = Format64(ep, 0, ToUnixSeconds(tp));
+      break;
+    case kSecondsFull:
+    case kSubsecondsFull:
+      bp = Format64(cp, 15, fs.count());
+      while (cp != bp && cp[-1] == '0') --cp;
+      if (kind == kSecondsFull) {
+        if (cp != bp) *--bp = '.';
+        bp = Format02d(bp, al.cs.second());
+      } else {
+        if (cp == bp) *--bp = '0';
+      }
+      break;
+    case kSecondsN:
+    case kSubsecondsN:
+      if (n > 0) {
+        bp = Format64(bp, n, (n > 15) ? fs.count() * kExp10[n - 15]
+                                      : fs.count() / kExp10[15 - n]);
+        if (kind == kSecondsN) *--bp = '.';
+      }
+      if (kind == kSecondsN) bp = Format02d(bp, al.cs.second());
+      break;
+  }
+  result->append(bp, static_cast<std::size_t>(cp - bp));
+}
+
+// The RFC3339 layouts, which are by far the most common formats, and which
+// format() and parse() recognize and handle without interpretation.
+const char kRFC3339FullFormat[] = "%Y-%m-%d%ET%H:%M:%E*S%Ez";
+const char kRFC3339SecFormat[] = "%Y-%m-%d%ET%H:%M:%S%Ez";
+
+// Returns whether the format is one of the RFC3339 layouts, and if so
+// whether it is the one with fractional seconds.
+bool IsRFC3339(const std::string& format, bool* frac) {
+  if (format.size() == sizeof(kRFC3339FullFormat) - 1 &&
+      std::memcmp(format.data(), kRFC3339FullFormat, format.size()) == 0) {
+    *frac = true;
+    return true;
+  }
+  if (format.size() == sizeof(kRFC3339SecFormat) - 1 &&
+      std::memcmp(format.data(), kRFC3339SecFormat, format.size()) == 0) {
+    *frac = false;
+    return true;
+  }
+  return false;
+}
+
+// Formats RFC3339_full, or RFC3339_sec when !frac, writing each field at
+// its fixed width rather than interpreting the format. The result is the
+// same as that of a Formatter.
+void FormatRFC3339(FormatOutput* out, const time_zone::absolute_lookup& al,
+                   const detail::femtoseconds& fs, bool frac) {
+  // Enough for the longest year and "-MM-DDTHH:MM:SS", followed by the
+  // subseconds and the offset.
+  char buf[(1 + kDigits10_64 + 15) + (1 + 15) + 9];
+  char* const mp = buf + (1 + kDigits10_64 + 15);
+  char* const bp = FormatDateTime(mp, al.cs, 'T');
+  char* ep = mp;
+  if (frac && fs.count() != 0) {
+    *ep++ = '.';
+    ep += 15;
+    Format64(ep, 15, fs.count());
+    while (ep[-1] == '0') --ep;
+  }
+  char offset[9];
+  char* const oe = offset + sizeof(offset);
+  const char* const op = FormatOffset(oe, al.offset, ":");
+  ep = std::copy(op, static_cast<const char*>(oe), ep);
+  out->append(bp, static_cast<std::size_t>(ep - bp));
+}
+
+// A ScanFormat() sink that formats as it goes.
+class Formatter {
+ public:
+  Formatter(FormatOutput* result, const time_zone::absolute_lookup& al,
+            const std::tm& tm, const time_point<seconds>& tp,
+            const detail::femtoseconds& fs)
+      : result_(result), al_(al), tm_(tm), tp_(tp), fs_(fs) {}
+
+  void Literal(const char* p, std::size_t n) { result_->append(p, n); }
+  void Strftime(const char* p, const char* ep) {
+    FormatTM(result_, p, ep, tm_);
+  }
+  void Field(FormatKind kind, int n) {
+    FormatField(result_, kind, n, al_, tp_, fs_);
+  }
+
+ private:
+  FormatOutput* result_;
+  const time_zone::absolute_lookup& al_;
+  const std::tm& tm_;
+  const time_point<seconds>& tp_;
+  const detail::femtoseconds& fs_;
+};
+
+// A ScanFormat() sink that records the operations of a format_plan.
+class FormatRecorder {
+ public:
+  explicit FormatRecorder(std::vector<format_op>* ops) : ops_(ops) {}
+
+  void Literal(const char* p, std::size_t n) {
+    if (n == 0) return;
+    if (ops_->empty() || ops_->back().kind != kLiteral) {
+      ops_->push_back({kLiteral, 0, std::string()});
+    }
+    ops_->back().text.append(p, n);
+  }
+  void Strftime(const char* p, const char* ep) {
+    ops_->push_back({kStrftime, 0, std::string(p, ep)});
+  }
+  void Field(FormatKind kind, int n) {
+    ops_->push_back({kind, n, std::string()});
+  }
+
+ private:
+  std::vector<format_op>* ops_;
+};
+
+// The expected width of a formatted field, used to size the result.
+std::size_t FieldWidth(const format_op& op) {
+  switch (op.kind) {
+    case kLiteral:
+      return op.text.size();
+    case kStrftime:
+      return op.text.size() * 2;
+    case kYear:
+    case kYear4:
+    case kAbbr:
+      return 4;
+    case kDate:
+      return 10;
+    case kTime:
+      return 8;
+    case kRFC3339Full:
+      return 25 + 1 + 9;  // with nanoseconds
+    case kRFC3339Sec:
+      return 25;
+    case kYearDay:
+    case kWeekdayName:
+    case kMonthName:
+      return 3;
+    case kWeekdayFullName:
+    case kMonthFullName:
+      return 8;
+    case kOffset:
+    case kOffsetColon:
+    case kOffsetMinimal:
+      return 6;
+    case kOffsetFull:
+      return 9;
+    case kUnixSeconds:
+      return 10;
+    case kSecondsFull:
+    case kSubsecondsFull:
+      return 2 + 1 + 15;
+    case kSecondsN:
+    case kSubsecondsN:
+      return 2 + 1 + static_cast<std::size_t>(op.n);
+    default:
+      return 2;
+  }
+}
+
+// Whether the LC_TIME locale might name the days and months differently
+// from the "C" locale, in which case format() leaves them to strftime().
+bool LocaleAwareNames() {
+  const char* name = std::setlocale(LC_TIME, nullptr);
+  return name != nullptr && std::strcmp(name, "C") != 0 &&
+         std::strcmp(name, "POSIX") != 0;
+}
+
+// Formats tp according to the format string (see format() below).
+void FormatTo(const std::string& format, const time_point<seconds>& tp,
+              const detail::femtoseconds& fs, const time_zone& tz,
+              FormatOutput* out) {
+  const time_zone::absolute_lookup al = tz.lookup(tp);
+  bool frac;
+  if (IsRFC3339(format, &frac)) {
+    FormatRFC3339(out, al, fs, frac);
+    return;
+  }
+  const std::tm tm = ToTM(al);
+  Formatter formatter(out, al, tm, tp, fs);
+  ScanFormat(format, LocaleAwareNames(), &formatter);
+}
+
+// Formats tp according to the operations of a format_plan.
+// The caller provides the lookup of tp, so that it may be done in batches.
+void FormatOps(const std::vector<format_op>& ops, bool needs_tm,
+               const time_zone::absolute_lookup& al,
+               const time_point<seconds>& tp, const detail::femtoseconds& fs,
+               FormatOutput* out) {
+  std::tm tm{};
+  if (needs_tm) tm = ToTM(al);
+  for (const format_op& op : ops) {
+    switch (op.kind) {
+      case kLiteral:
+        out->append(op.text);
+        break;
+      case kStrftime:
+        FormatTM(out, op.text.c_str(), op.text.size(), tm);
+        break;
+      case kRFC3339Full:
+      case kRFC3339Sec:
+        FormatRFC3339(out, al, fs, op.kind == kRFC3339Full);
+        break;
+      default:
+        FormatField(out, static_cast<FormatKind>(op.kind), op.n, al, tp, fs);
+        break;
+    }
+  }
+}
+
+}  // namespace
+
+// Uses strftime(3) to format the given Time.  The following extended format
+// specifiers are also supported:
+//
+//   - %Ez  - RFC3339-compatible numeric UTC offset (+hh:mm or -hh:mm)
+//   - %E*z - Full-resolution numeric UTC offset (+hh:mm:ss or -hh:mm:ss)
+//   - %E#S - Seconds with # digits of fractional precision
+//   - %E*S - Seconds with full fractional precision (a literal '*')
+//   - %E4Y - Four-character years (-999 ... -001, 0000, 0001 ... 9999)
+//   - %ET  - The RFC3339 "date-time" separator "T"
+//
+// The standard specifiers from RFC3339_* (%Y, %m, %d, %H, %M, and %S) are
+// handled internally for performance reasons.  strftime(3) is slow due to
+// a POSIX requirement to respect changes to ${TZ}.  For the same reason
+// %y, %j, %D, %F, %R, and %T, and, when the LC_TIME locale is "C" or
+// "POSIX", %a, %A, %b, %h, %B, and %p are also handled internally.
+// The RFC3339_* layouts themselves are recognized, and formatted without
+// interpreting them at all.
+//
+// The TZ/GNU %s extension is handled internally because strftime() has
+// to use mktime() to generate it, and that assumes the local time zone.
+//
+// We also handle the %z and %Z specifiers to accommodate platforms that do
+// not support the tm_gmtoff and tm_zone extensions to std::tm.
+//
+// Requires that zero() <= fs < seconds(1).
+std::string format(const std::string& format, const time_point<seconds>& tp,
+                   const detail::femtoseconds& fs, const time_zone& tz) {
+  std::string result;
+  result.reserve(format.size());  // A reasonable guess for the result size.
+  FormatOutput out(&result);
+  FormatTo(format, tp, fs, tz, &out);
+  return result;
+}
+
+std::size_t format(const std::string& format, const time_point<seconds>& tp,
+                   const detail::femtoseconds& fs, const time_zone& tz,
+                   char* buf, std::size_t size) {
+  FormatOutput out(buf, size);
+  FormatTo(format, tp, fs, tz, &out);
+  return out.size();
+}
+
+std::size_t format(const std::string& format, const time_point<seconds>& tp,
+                   const detail::femtoseconds& fs, const time_zone& tz,
+                   std::string* result) {
+  FormatOutput out(result);
+  FormatTo(format, tp, fs, tz, &out);
+  return out.size();
+}
+
+void format_many(const format_plan& plan, const time_point<seconds>* tps,
+                 const femtoseconds* fss, std::size_t n,
+                 time_zone::cursor* cur, format_arena* arena) {
+  // This is called for each chunk of a column, so the buffers grow at least
+  // geometrically rather than by exactly what each chunk needs.
+  const std::size_t offsets = arena->offsets.size() + n;
+  if (offsets > arena->offsets.capacity()) {
+    arena->offsets.reserve(std::max(offsets, 2 * arena->offsets.capacity()));
   }
+  const std::size_t data = arena->data.size() + n * plan.size_hint_;
+  if (data > arena->data.capacity()) {
+    arena->data.reserve(std::max(data, 2 * arena->data.capacity()));
+  }
+  FormatOutput out(&arena->data);
+  for (std::size_t i = 0; i != n; ++i) {
+    FormatOps(plan.ops_, plan.needs_tm_, cur->lookup(tps[i]), tps[i], fss[i],
+              &out);
+    arena->offsets.push_back(arena->data.size());
+  }
+}
 
+}  // namespace detail
+
+format_plan::format_plan(const std::string& fmt, bool locale_aware)
+    : size_hint_(0), needs_tm_(false) {
+  bool frac;
+  if (detail::IsRFC3339(fmt, &frac)) {
+    ops_.push_back({frac ? detail::kRFC3339Full : detail::kRFC3339Sec, 0,
+                    std::string()});
+  } else {
+    detail::FormatRecorder recorder(&ops_);
+    detail::ScanFormat(fmt, locale_aware, &recorder);
+  }
+  for (const detail::format_op& op : ops_) {
+    size_hint_ += detail::FieldWidth(op);
+    if (op.kind == detail::kStrftime) needs_tm_ = true;
+  }
+}
+
+std::string format_plan::format(const time_point<seconds>& tp,
+                                const detail::femtoseconds& fs,
+                                const time_zone& tz) const {
+  std::string result;
+  result.reserve(size_hint_);
+  detail::FormatOutput out(&result);
+  detail::FormatOps(ops_, needs_tm_, tz.lookup(tp), tp, fs, &out);
   return result;
 }
 
+std::size_t format_plan::format(const time_point<seconds>& tp,
+                                const detail::femtoseconds& fs,
+                                const time_zone& tz, char* buf,
+                                std::size_t size) const {
+  detail::FormatOutput out(buf, size);
+  detail::FormatOps(ops_, needs_tm_, tz.lookup(tp), tp, fs, &out);
+  return out.size();
+}
+
+std::size_t format_plan::format(const time_point<seconds>& tp,
+                                const detail::femtoseconds& fs,
+                                const time_zone& tz, std::string* out) const {
+  detail::FormatOutput output(out);
+  detail::FormatOps(ops_, needs_tm_, tz.lookup(tp), tp, fs, &output);
+  return output.size();
+}
+
+namespace detail {
+
 namespace {
 
 const char* ParseOffset(const char* dp, const char* mode, int* offset) {
@@ -581,15 +1218,15 @@ const char* ParseOffset(const char* dp, const char* mode, int* offset) {
       int hours = 0;
       int minutes = 0;
       int seconds = 0;
-      const char* ap = ParseInt(dp, 2, 0, 23, &hours);
+      const char* ap = ParseInt2(dp, 0, 23, &hours);
       if (ap != nullptr && ap - dp == 2) {
         dp = ap;
         if (sep != '\0' && *ap == sep) ++ap;
-        const char* bp = ParseInt(ap, 2, 0, 59, &minutes);
+        const char* bp = ParseInt2(ap, 0, 59, &minutes);
         if (bp != nullptr && bp - ap == 2) {
           dp = bp;
           if (sep != '\0' && *bp == sep) ++bp;
-          const char* cp = ParseInt(bp, 2, 0, 59, &seconds);
+          const char* cp = ParseInt2(bp, 0, 59, &seconds);
           if (cp != nullptr && cp - bp == 2) dp = cp;
         }
         *offset = ((hours * 60 + minutes) * 60) + seconds;
@@ -606,36 +1243,26 @@ const char* ParseOffset(const char* dp, const char* mode, int* offset) {
   return dp;
 }
 
-const char* ParseZone(const char* dp, std::string* zone) {
-  zone->clear();
+const char* ParseZone(const char* dp) {
   if (dp != nullptr) {
-    while (*dp != '\0' && !std::isspace(*dp)) zone->push_back(*dp++);
-    if (zone->empty()) dp = nullptr;
+    const char* const bp = dp;
+    while (*dp != '\0' && !std::isspace(*dp)) ++dp;
+    if (dp == bp) dp = nullptr;
   }
   return dp;
 }
 
 const char* ParseSubSeconds(const char* dp, detail::femtoseconds* subseconds) {
   if (dp != nullptr) {
-    std::int_fast64_t v = 0;
-    std::int_fast64_t exp = 0;
-    const char* const bp = dp;
-    while (const char* cp = strchr(kDigits, *dp)) {
-      int d = static_cast<int>(cp - kDigits);
-      if (d >= 10) break;
-      if (exp < 15) {
-        exp += 1;
-        v *= 10;
-        v += d;
-      }
-      ++dp;
-    }
-    if (dp != bp) {
-      v *= kExp10[15 - exp];
-      *subseconds = detail::femtoseconds(v);
-    } else {
-      dp = nullptr;
-    }
+    // Only the first 15 digits are significant, but all are consumed.
+    const int n = DigitRun(dp, 0);
+    if (n == 0) return nullptr;
+    const int exp = std::min(n, 15);
+    std::uint_fast64_t v = 0;
+    ParseDigits(dp, exp, std::numeric_limits<std::uint_fast64_t>::max(), &v);
+    *subseconds = detail::femtoseconds(static_cast<std::int_fast64_t>(v) *
+                                       kExp10[15 - exp]);
+    dp += n;
   }
   return dp;
 }
@@ -668,206 +1295,154 @@ bool FromWeek(int week_num, weekday week_start, year_t* year, std::tm* tm) {
   return true;
 }
 
-}  // namespace
-
-// Uses strptime(3) to parse the given input.  Supports the same extended
-// format specifiers as format(), although %E#S and %E*S are treated
-// identically (and similarly for %E#f and %E*f).  %Ez and %E*z also accept
-// the same inputs. %ET accepts either 'T' or 't'.
-//
-// The standard specifiers from RFC3339_* (%Y, %m, %d, %H, %M, and %S) are
-// handled internally so that we can normally avoid strptime() altogether
-// (which is particularly helpful when the native implementation is broken).
-//
-// The TZ/GNU %s extension is handled internally because strptime() has to
-// use localtime_r() to generate it, and that assumes the local time zone.
-//
-// We also handle the %z specifier to accommodate platforms that do not
-// support the tm_gmtoff extension to std::tm.  %Z is parsed but ignored.
-bool parse(const std::string& format, const std::string& input,
-           const time_zone& tz, time_point<seconds>* sec,
-           detail::femtoseconds* fs, std::string* err) {
-  // The unparsed input.
-  const char* data = input.c_str();  // NUL terminated
-
-  // Skips leading whitespace.
-  while (std::isspace(*data)) ++data;
-
-  const year_t kyearmax = std::numeric_limits<year_t>::max();
-  const year_t kyearmin = std::numeric_limits<year_t>::min();
-
-  // Sets default values for unspecified fields.
-  bool saw_year = false;
-  year_t year = 1970;
-  std::tm tm{};
-  tm.tm_year = 1970 - 1900;
-  tm.tm_mon = 1 - 1;  // Jan
-  tm.tm_mday = 1;
-  tm.tm_hour = 0;
-  tm.tm_min = 0;
-  tm.tm_sec = 0;
-  tm.tm_wday = 4;  // Thu
-  tm.tm_yday = 0;
-  tm.tm_isdst = 0;
-  auto subseconds = detail::femtoseconds::zero();
-  bool saw_offset = false;
-  int offset = 0;  // No offset from passed tz.
-  std::string zone = "UTC";
+// The specifiers of a format that we parse ourselves. These are the kinds
+// of the operations in a parse_plan, along with kSpace for whitespace,
+// kLiteral for text that must match exactly, kFail for a trailing '%', and
+// kStrptime for a specifier that is parsed by strptime().
+enum class ParseKind : std::uint_least8_t {
+  kSpace,
+  kLiteral,
+  kFail,
+  kStrptime,
+  kStrptimeAmPm,     // %p, by strptime()
+  kYear,             // %Y
+  kYear4,            // %E4Y
+  kMonth,            // %m
+  kDay,              // %d and %e
+  kWeekSunday,       // %U
+  kWeekMonday,       // %W
+  kWeekdayMonday1,   // %u
+  kWeekdaySunday0,   // %w
+  kHour,             // %H
+  kMinute,           // %M
+  kSecond,           // %S
+  kOffset,           // %z
+  kOffsetColon,      // %:z, %::z, %:::z, %Ez and %E*z
+  kZone,             // %Z
+  kUnixSeconds,      // %s
+  kPercent,          // %%
+  kDateTimeSep,      // %ET
+  kSecondsFrac,      // %E*S and %E#S
+  kSubseconds,       // %E*f and %E#f
+  kRFC3339Full,      // the whole of RFC3339_full
+  kRFC3339Sec,       // the whole of RFC3339_sec
+};
 
+// Scans a format string, reporting each of its parsing operations to the
+// sink, in order, while sink->ok(). This is the parse() format parser,
+// which a parse_plan also uses to record its operations.
+template <typename Sink>
+void ScanParse(const std::string& format, Sink* sink) {
   const char* fmt = format.c_str();  // NUL terminated
-  bool twelve_hour = false;
-  bool afternoon = false;
-  int week_num = -1;
-  weekday week_start = weekday::sunday;
-
-  bool saw_percent_s = false;
-  std::int_fast64_t percent_s = 0;
 
   // Steps through format, one specifier at a time.
-  while (data != nullptr && *fmt != '\0') {
+  while (sink->ok() && *fmt != '\0') {
     if (std::isspace(*fmt)) {
-      while (std::isspace(*data)) ++data;
+      sink->Space();
       while (std::isspace(*++fmt)) continue;
       continue;
     }
 
     if (*fmt != '%') {
-      if (*data == *fmt) {
-        ++data;
-        ++fmt;
-      } else {
-        data = nullptr;
-      }
+      const char* const bp = fmt;
+      while (*fmt != '\0' && *fmt != '%' && !std::isspace(*fmt)) ++fmt;
+      sink->Literal(bp, static_cast<std::size_t>(fmt - bp));
       continue;
     }
 
     const char* percent = fmt;
     if (*++fmt == '\0') {
-      data = nullptr;
+      sink->Field(ParseKind::kFail);
       continue;
     }
+    int clock = 0;  // the 12/24-hour clock the specifier implies, if any
     switch (*fmt++) {
       case 'Y':
-        // Symmetrically with FormatTime(), directly handing %Y avoids the
-        // tm.tm_year overflow problem.  However, tm.tm_year will still be
-        // used by other specifiers like %D.
-        data = ParseInt(data, 0, kyearmin, kyearmax, &year);
-        if (data != nullptr) saw_year = true;
+        sink->Field(ParseKind::kYear);
         continue;
       case 'm':
-        data = ParseInt(data, 2, 1, 12, &tm.tm_mon);
-        if (data != nullptr) tm.tm_mon -= 1;
-        week_num = -1;
+        sink->Field(ParseKind::kMonth);
         continue;
       case 'd':
       case 'e':
-        data = ParseInt(data, 2, 1, 31, &tm.tm_mday);
-        week_num = -1;
+        sink->Field(ParseKind::kDay);
         continue;
       case 'U':
-        data = ParseInt(data, 0, 0, 53, &week_num);
-        week_start = weekday::sunday;
+        sink->Field(ParseKind::kWeekSunday);
         continue;
       case 'W':
-        data = ParseInt(data, 0, 0, 53, &week_num);
-        week_start = weekday::monday;
+        sink->Field(ParseKind::kWeekMonday);
         continue;
       case 'u':
-        data = ParseInt(data, 0, 1, 7, &tm.tm_wday);
-        if (data != nullptr) tm.tm_wday %= 7;
+        sink->Field(ParseKind::kWeekdayMonday1);
         continue;
       case 'w':
-        data = ParseInt(data, 0, 0, 6, &tm.tm_wday);
+        sink->Field(ParseKind::kWeekdaySunday0);
         continue;
       case 'H':
-        data = ParseInt(data, 2, 0, 23, &tm.tm_hour);
-        twelve_hour = false;
+        sink->Field(ParseKind::kHour);
         continue;
       case 'M':
-        data = ParseInt(data, 2, 0, 59, &tm.tm_min);
+        sink->Field(ParseKind::kMinute);
         continue;
       case 'S':
-        data = ParseInt(data, 2, 0, 60, &tm.tm_sec);
+        sink->Field(ParseKind::kSecond);
         continue;
       case 'I':
       case 'l':
       case 'r':  // probably uses %I
-        twelve_hour = true;
+        clock = 12;
         break;
       case 'R':  // uses %H
       case 'T':  // uses %H
       case 'c':  // probably uses %H
       case 'X':  // probably uses %H
-        twelve_hour = false;
+        clock = 24;
         break;
       case 'z':
-        data = ParseOffset(data, "", &offset);
-        if (data != nullptr) saw_offset = true;
+        sink->Field(ParseKind::kOffset);
         continue;
       case 'Z':  // ignored; zone abbreviations are ambiguous
-        data = ParseZone(data, &zone);
+        sink->Field(ParseKind::kZone);
         continue;
       case 's':
-        data = ParseInt(data, 0,
-                        std::numeric_limits<std::int_fast64_t>::min(),
-                        std::numeric_limits<std::int_fast64_t>::max(),
-                        &percent_s);
-        if (data != nullptr) saw_percent_s = true;
+        sink->Field(ParseKind::kUnixSeconds);
         continue;
       case ':':
         if (fmt[0] == 'z' ||
             (fmt[0] == ':' &&
              (fmt[1] == 'z' || (fmt[1] == ':' && fmt[2] == 'z')))) {
-          data = ParseOffset(data, ":", &offset);
-          if (data != nullptr) saw_offset = true;
+          sink->Field(ParseKind::kOffsetColon);
           fmt += (fmt[0] == 'z') ? 1 : (fmt[1] == 'z') ? 2 : 3;
           continue;
         }
         break;
       case '%':
-        data = (*data == '%' ? data + 1 : nullptr);
+        sink->Field(ParseKind::kPercent);
         continue;
       case 'E':
         if (fmt[0] == 'T') {
-          if (*data == 'T' || *data == 't') {
-            ++data;
-            ++fmt;
-          } else {
-            data = nullptr;
-          }
+          sink->Field(ParseKind::kDateTimeSep);
+          ++fmt;
           continue;
         }
         if (fmt[0] == 'z' || (fmt[0] == '*' && fmt[1] == 'z')) {
-          data = ParseOffset(data, ":", &offset);
-          if (data != nullptr) saw_offset = true;
+          sink->Field(ParseKind::kOffsetColon);
           fmt += (fmt[0] == 'z') ? 1 : 2;
           continue;
         }
         if (fmt[0] == '*' && fmt[1] == 'S') {
-          data = ParseInt(data, 2, 0, 60, &tm.tm_sec);
-          if (data != nullptr && *data == '.') {
-            data = ParseSubSeconds(data + 1, &subseconds);
-          }
+          sink->Field(ParseKind::kSecondsFrac);
           fmt += 2;
           continue;
         }
         if (fmt[0] == '*' && fmt[1] == 'f') {
-          if (data != nullptr && std::isdigit(*data)) {
-            data = ParseSubSeconds(data, &subseconds);
-          }
+          sink->Field(ParseKind::kSubseconds);
           fmt += 2;
           continue;
         }
         if (fmt[0] == '4' && fmt[1] == 'Y') {
-          const char* bp = data;
-          data = ParseInt(data, 4, year_t{-999}, year_t{9999}, &year);
-          if (data != nullptr) {
-            if (data - bp == 4) {
-              saw_year = true;
-            } else {
-              data = nullptr;  // stopped too soon
-            }
-          }
+          sink->Field(ParseKind::kYear4);
           fmt += 2;
           continue;
         }
@@ -875,54 +1450,317 @@ bool parse(const std::string& format, const std::string& input,
           int n = 0;  // value ignored
           if (const char* np = ParseInt(fmt, 0, 0, 1024, &n)) {
             if (*np == 'S') {
-              data = ParseInt(data, 2, 0, 60, &tm.tm_sec);
-              if (data != nullptr && *data == '.') {
-                data = ParseSubSeconds(data + 1, &subseconds);
-              }
+              sink->Field(ParseKind::kSecondsFrac);
               fmt = ++np;
               continue;
             }
             if (*np == 'f') {
-              if (data != nullptr && std::isdigit(*data)) {
-                data = ParseSubSeconds(data, &subseconds);
-              }
+              sink->Field(ParseKind::kSubseconds);
               fmt = ++np;
               continue;
             }
           }
         }
-        if (*fmt == 'c') twelve_hour = false;  // probably uses %H
-        if (*fmt == 'X') twelve_hour = false;  // probably uses %H
+        if (*fmt == 'c') clock = 24;  // probably uses %H
+        if (*fmt == 'X') clock = 24;  // probably uses %H
         if (*fmt != '\0') ++fmt;
         break;
       case 'O':
-        if (*fmt == 'H') twelve_hour = false;
-        if (*fmt == 'I') twelve_hour = true;
+        if (*fmt == 'H') clock = 24;
+        if (*fmt == 'I') clock = 12;
         if (*fmt != '\0') ++fmt;
         break;
     }
 
-    // Parses the current specifier.
-    const char* orig_data = data;
-    std::string spec(percent, static_cast<std::size_t>(fmt - percent));
-    data = ParseTM(data, spec.c_str(), &tm);
-
-    // If we successfully parsed %p we need to remember whether the result
-    // was AM or PM so that we can adjust tm_hour before time_zone::lookup().
-    // So reparse the input with a known AM hour, and check if it is shifted
-    // to a PM hour.
-    if (spec == "%p" && data != nullptr) {
-      std::string test_input = "1";
-      test_input.append(orig_data, static_cast<std::size_t>(data - orig_data));
-      const char* test_data = test_input.c_str();
-      std::tm tmp{};
-      ParseTM(test_data, "%I%p", &tmp);
-      afternoon = (tmp.tm_hour == 13);
+    // Parses the current specifier with strptime().
+    sink->Strptime(percent, fmt, clock);
+  }
+}
+
+// The fields of a parse in progress.
+struct ParseState {
+  ParseState() {
+    // Sets default values for unspecified fields.
+    tm.tm_year = 1970 - 1900;
+    tm.tm_mon = 1 - 1;  // Jan
+    tm.tm_mday = 1;
+    tm.tm_hour = 0;
+    tm.tm_min = 0;
+    tm.tm_sec = 0;
+    tm.tm_wday = 4;  // Thu
+    tm.tm_yday = 0;
+    tm.tm_isdst = 0;
+  }
+
+  const char* data = nullptr;  // the unparsed input
+  bool saw_year = false;
+  year_t year = 1970;
+  std::tm tm{};
+  detail::femtoseconds subseconds = detail::femtoseconds::zero();
+  bool saw_offset = false;
+  int offset = 0;  // No offset from passed tz.
+  bool twelve_hour = false;
+  bool afternoon = false;
+  int week_num = -1;
+  weekday week_start = weekday::sunday;
+  bool saw_percent_s = false;
+  std::int_fast64_t percent_s = 0;
+};
+
+// Matches whitespace or literal text against the input.
+void ParseSpace(ParseState* st) {
+  while (std::isspace(*st->data)) ++st->data;
+}
+void ParseLiteral(const char* p, std::size_t n, ParseState* st) {
+  st->data = (std::strncmp(st->data, p, n) == 0) ? st->data + n : nullptr;
+}
+
+// Parses a specifier that we handle ourselves.
+void ParseField(ParseKind kind, ParseState* st) {
+  const year_t kyearmax = std::numeric_limits<year_t>::max();
+  const year_t kyearmin = std::numeric_limits<year_t>::min();
+  const char*& data = st->data;
+  std::tm& tm = st->tm;
+  switch (kind) {
+    case ParseKind::kSpace:
+      ParseSpace(st);
+      break;
+    case ParseKind::kLiteral:
+    case ParseKind::kStrptime:
+    case ParseKind::kStrptimeAmPm:
+    case ParseKind::kRFC3339Full:
+    case ParseKind::kRFC3339Sec:
+      break;
+    case ParseKind::kFail:
+      data = nullptr;
+      break;
+    case ParseKind::kYear:
+      // Symmetrically with FormatTime(), directly handing %Y avoids the
+      // tm.tm_year overflow problem.  However, tm.tm_year will still be
+      // used by other specifiers like %D.
+      data = ParseInt(data, 0, kyearmin, kyearmax, &st->year);
+      if (data != nullptr) st->saw_year = true;
+      break;
+    case ParseKind::kYear4: {
+      const char* bp = data;
+      data = ParseInt(data, 4, year_t{-999}, year_t{9999}, &st->year);
+      if (data != nullptr) {
+        if (data - bp == 4) {
+          st->saw_year = true;
+        } else {
+          data = nullptr;  // stopped too soon
+        }
+      }
+      break;
+    }
+    case ParseKind::kMonth:
+      data = ParseInt2(data, 1, 12, &tm.tm_mon);
+      if (data != nullptr) tm.tm_mon -= 1;
+      st->week_num = -1;
+      break;
+    case ParseKind::kDay:
+      data = ParseInt2(data, 1, 31, &tm.tm_mday);
+      st->week_num = -1;
+      break;
+    case ParseKind::kWeekSunday:
+      data = ParseInt(data, 0, 0, 53, &st->week_num);
+      st->week_start = weekday::sunday;
+      break;
+    case ParseKind::kWeekMonday:
+      data = ParseInt(data, 0, 0, 53, &st->week_num);
+      st->week_start = weekday::monday;
+      break;
+    case ParseKind::kWeekdayMonday1:
+      data = ParseInt(data, 0, 1, 7, &tm.tm_wday);
+      if (data != nullptr) tm.tm_wday %= 7;
+      break;
+    case ParseKind::kWeekdaySunday0:
+      data = ParseInt(data, 0, 0, 6, &tm.tm_wday);
+      break;
+    case ParseKind::kHour:
+      data = ParseInt2(data, 0, 23, &tm.tm_hour);
+      st->twelve_hour = false;
+      break;
+    case ParseKind::kMinute:
+      data = ParseInt2(data, 0, 59, &tm.tm_min);
+      break;
+    case ParseKind::kSecond:
+      data = ParseInt2(data, 0, 60, &tm.tm_sec);
+      break;
+    case ParseKind::kOffset:
+      data = ParseOffset(data, "", &st->offset);
+      if (data != nullptr) st->saw_offset = true;
+      break;
+    case ParseKind::kOffsetColon:
+      data = ParseOffset(data, ":", &st->offset);
+      if (data != nullptr) st->saw_offset = true;
+      break;
+    case ParseKind::kZone:
+      data = ParseZone(data);
+      break;
+    case ParseKind::kUnixSeconds:
+      data = ParseInt(data, 0,
+                      std::numeric_limits<std::int_fast64_t>::min(),
+                      std::numeric_limits<std::int_fast64_t>::max(),
+                      &st->percent_s);
+      if (data != nullptr) st->saw_percent_s = true;
+      break;
+    case ParseKind::kPercent:
+      data = (*data == '%' ? data + 1 : nullptr);
+      break;
+    case ParseKind::kDateTimeSep:
+      data = (*data == 'T' || *data == 't') ? data + 1 : nullptr;
+      break;
+    case ParseKind::kSecondsFrac:
+      data = ParseInt2(data, 0, 60, &tm.tm_sec);
+      if (data != nullptr && *data == '.') {
+        data = ParseSubSeconds(data + 1, &st->subseconds);
+      }
+      break;
+    case ParseKind::kSubseconds:
+      if (data != nullptr && std::isdigit(*data)) {
+        data = ParseSubSeconds(data, &st->subseconds);
+      }
+      break;
+  }
+}
+
+// Parses a specifier using strptime(), given as a NUL-terminated spec.
+void ParseStrptime(const char* spec, int clock, bool ampm, ParseState* st) {
+  if (clock != 0) st->twelve_hour = (clock == 12);
+  const char* orig_data = st->data;
+  st->data = ParseTM(st->data, spec, &st->tm);
+
+  // If we successfully parsed %p we need to remember whether the result
+  // was AM or PM so that we can adjust tm_hour before time_zone::lookup().
+  // So reparse the input with a known AM hour, and check if it is shifted
+  // to a PM hour.
+  if (ampm && st->data != nullptr) {
+    std::string test_input = "1";
+    test_input.append(orig_data,
+                      static_cast<std::size_t>(st->data - orig_data));
+    const char* test_data = test_input.c_str();
+    std::tm tmp{};
+    ParseTM(test_data, "%I%p", &tmp);
+    st->afternoon = (tmp.tm_hour == 13);
+  }
+}
+
+bool IsAmPm(const char* spec, const char* ep) {
+  return ep - spec == 2 && spec[1] == 'p';
+}
+
+// A ScanParse() sink that parses as it goes.
+class Parser {
+ public:
+  explicit Parser(ParseState* st) : st_(st) {}
+
+  bool ok() const { return st_->data != nullptr; }
+  void Space() { ParseSpace(st_); }
+  void Literal(const char* p, std::size_t n) { ParseLiteral(p, n, st_); }
+  void Field(ParseKind kind) { ParseField(kind, st_); }
+  void Strptime(const char* spec, const char* ep, int clock) {
+    ParseStrptime(std::string(spec, ep).c_str(), clock, IsAmPm(spec, ep),
+                  st_);
+  }
+
+ private:
+  ParseState* st_;
+};
+
+// Returns the value of the two digits at dp, or -1 if they are not digits.
+int FixedInt2(const char* dp) {
+  const unsigned d0 = static_cast<unsigned char>(dp[0]) - unsigned{'0'};
+  const unsigned d1 = static_cast<unsigned char>(dp[1]) - unsigned{'0'};
+  return (d0 <= 9 && d1 <= 9) ? static_cast<int>(d0 * 10 + d1) : -1;
+}
+
+// Parses RFC3339_full, or RFC3339_sec when !frac, given the size of the
+// remaining input. When the input has the usual shape, with a four-digit
+// year and two-digit fields, the date and time are read at their fixed
+// positions. Otherwise the format is interpreted by a Parser, so that the
+// result (including any error) is always the same as that of a Parser.
+void ParseRFC3339(bool frac, std::size_t size, ParseState* st) {
+  const char* dp = st->data;
+  if (size >= 19 && dp[4] == '-' && dp[7] == '-' &&
+      (dp[10] == 'T' || dp[10] == 't') && dp[13] == ':' && dp[16] == ':') {
+    const int year_hi = FixedInt2(dp + 0);
+    const int year_lo = FixedInt2(dp + 2);
+    const int month = FixedInt2(dp + 5);
+    const int day = FixedInt2(dp + 8);
+    const int hour = FixedInt2(dp + 11);
+    const int minute = FixedInt2(dp + 14);
+    const int second = FixedInt2(dp + 17);
+    if (year_hi >= 0 && year_lo >= 0 && 1 <= month && month <= 12 &&
+        1 <= day && day <= 31 && 0 <= hour && hour <= 23 && 0 <= minute &&
+        minute <= 59 && 0 <= second && second <= 60) {
+      st->year = year_hi * 100 + year_lo;
+      st->saw_year = true;
+      st->tm.tm_mon = month - 1;
+      st->tm.tm_mday = day;
+      st->tm.tm_hour = hour;
+      st->tm.tm_min = minute;
+      st->tm.tm_sec = second;
+      dp += 19;
+      if (frac && *dp == '.') dp = ParseSubSeconds(dp + 1, &st->subseconds);
+      dp = ParseOffset(dp, ":", &st->offset);
+      if (dp != nullptr) st->saw_offset = true;
+      st->data = dp;
+      return;
     }
   }
+  Parser parser(st);
+  ScanParse(frac ? kRFC3339FullFormat : kRFC3339SecFormat, &parser);
+}
+
+// A ScanParse() sink that records the operations of a parse_plan.
+class ParseRecorder {
+ public:
+  explicit ParseRecorder(std::vector<parse_op>* ops) : ops_(ops) {}
+
+  bool ok() const { return true; }
+  void Space() { Push(ParseKind::kSpace, 0, std::string()); }
+  void Literal(const char* p, std::size_t n) {
+    Push(ParseKind::kLiteral, 0, std::string(p, n));
+  }
+  void Field(ParseKind kind) { Push(kind, 0, std::string()); }
+  void Strptime(const char* spec, const char* ep, int clock) {
+    const ParseKind kind =
+        IsAmPm(spec, ep) ? ParseKind::kStrptimeAmPm : ParseKind::kStrptime;
+    Push(kind, clock, std::string(spec, ep));
+  }
+
+ private:
+  void Push(ParseKind kind, int n, std::string text) {
+    ops_->push_back(
+        {static_cast<std::uint_least8_t>(kind), n, std::move(text)});
+  }
+
+  std::vector<parse_op>* ops_;
+};
+
+// The result of a parse before it is made absolute: either the civil time
+// it denotes, less any parsed UTC offset, or the absolute time from %s.
+struct ParsedCivil {
+  civil_second cs;
+  bool utc;           // cs is in UTC, rather than in the passed time_zone
+  bool unix_seconds;  // the result is unix_tp
+  time_point<seconds> unix_tp;
+  detail::femtoseconds subseconds;
+};
+
+// Converts the parsed fields to a civil time, once the format has been
+// exhausted.
+bool ParseCivil(ParseState* st, ParsedCivil* pc, std::string* err) {
+  const year_t kyearmax = std::numeric_limits<year_t>::max();
+  const char* data = st->data;
+  std::tm& tm = st->tm;
+  year_t year = st->year;
+  int offset = st->offset;
+  auto subseconds = st->subseconds;
 
   // Adjust a 12-hour tm_hour value if it should be in the afternoon.
-  if (twelve_hour && afternoon && tm.tm_hour < 12) {
+  if (st->twelve_hour && st->afternoon && tm.tm_hour < 12) {
     tm.tm_hour += 12;
   }
 
@@ -941,16 +1779,17 @@ bool parse(const std::string& format, const std::string& input,
   }
 
   // If we saw %s then we ignore anything else and return that time.
-  if (saw_percent_s) {
-    *sec = FromUnixSeconds(percent_s);
-    *fs = detail::femtoseconds::zero();
+  pc->unix_seconds = st->saw_percent_s;
+  if (st->saw_percent_s) {
+    pc->unix_tp = FromUnixSeconds(st->percent_s);
+    pc->subseconds = detail::femtoseconds::zero();
     return true;
   }
 
   // If we saw %z, %Ez, or %E*z then we want to interpret the parsed fields
   // in UTC and then shift by that offset.  Otherwise we want to interpret
   // the fields directly in the passed time_zone.
-  time_zone ptz = saw_offset ? utc_time_zone() : tz;
+  pc->utc = st->saw_offset;
 
   // Allows a leap second of 60 to normalize forward to the following ":00".
   if (tm.tm_sec == 60) {
@@ -959,7 +1798,7 @@ bool parse(const std::string& format, const std::string& input,
     subseconds = detail::femtoseconds::zero();
   }
 
-  if (!saw_year) {
+  if (!st->saw_year) {
     year = year_t{tm.tm_year};
     if (year > kyearmax - 1900) {
       // Platform-dependent, maybe unreachable.
@@ -970,8 +1809,8 @@ bool parse(const std::string& format, const std::string& input,
   }
 
   // Compute year, tm.tm_mon and tm.tm_mday if we parsed a week number.
-  if (week_num != -1) {
-    if (!FromWeek(week_num, week_start, &year, &tm)) {
+  if (st->week_num != -1) {
+    if (!FromWeek(st->week_num, st->week_start, &year, &tm)) {
       if (err != nullptr) *err = "Out-of-range field";
       return false;
     }
@@ -994,29 +1833,199 @@ bool parse(const std::string& format, const std::string& input,
     if (err != nullptr) *err = "Out-of-range field";
     return false;
   }
-  cs -= offset;
+  pc->cs = cs - offset;
+  pc->subseconds = subseconds;
+  return true;
+}
+
+// Converts a parsed civil time to an absolute time, given its lookup in
+// ptz (which is UTC when pc.utc).
+bool ParseAbsolute(const ParsedCivil& pc, const time_zone::civil_lookup& cl,
+                   const time_zone& ptz, time_point<seconds>* sec,
+                   detail::femtoseconds* fs, std::string* err) {
+  if (pc.unix_seconds) {
+    *sec = pc.unix_tp;
+    *fs = pc.subseconds;
+    return true;
+  }
 
-  const auto tp = ptz.lookup(cs).pre;
+  const auto tp = cl.pre;
   // Checks for overflow/underflow and returns an error as necessary.
   if (tp == time_point<seconds>::max()) {
     const auto al = ptz.lookup(time_point<seconds>::max());
-    if (cs > al.cs) {
+    if (pc.cs > al.cs) {
       if (err != nullptr) *err = "Out-of-range field";
       return false;
     }
   }
   if (tp == time_point<seconds>::min()) {
     const auto al = ptz.lookup(time_point<seconds>::min());
-    if (cs < al.cs) {
+    if (pc.cs < al.cs) {
       if (err != nullptr) *err = "Out-of-range field";
       return false;
     }
   }
 
   *sec = tp;
-  *fs = subseconds;
+  *fs = pc.subseconds;
   return true;
 }
 
+// Converts the parsed fields to an absolute time, once the format has
+// been exhausted.
+bool ParseResult(ParseState* st, const time_zone& tz, time_point<seconds>* sec,
+                 detail::femtoseconds* fs, std::string* err) {
+  ParsedCivil pc;
+  if (!ParseCivil(st, &pc, err)) return false;
+  if (pc.unix_seconds) {
+    return ParseAbsolute(pc, time_zone::civil_lookup(), tz, sec, fs, err);
+  }
+  const time_zone ptz = pc.utc ? utc_time_zone() : tz;
+  return ParseAbsolute(pc, ptz.lookup(pc.cs), ptz, sec, fs, err);
+}
+
+// Parses the input according to the operations of a parse_plan, leaving
+// the fields in st for ParseResult().
+void ParsePlan(const std::vector<parse_op>& ops, const std::string& input,
+               ParseState* st) {
+  st->data = input.c_str();  // NUL terminated
+
+  // Skips leading whitespace.
+  ParseSpace(st);
+
+  for (const parse_op& op : ops) {
+    if (st->data == nullptr) break;
+    const ParseKind kind = static_cast<ParseKind>(op.kind);
+    switch (kind) {
+      case ParseKind::kLiteral:
+        ParseLiteral(op.text.data(), op.text.size(), st);
+        break;
+      case ParseKind::kStrptime:
+      case ParseKind::kStrptimeAmPm:
+        ParseStrptime(op.text.c_str(), op.n,
+                      kind == ParseKind::kStrptimeAmPm, st);
+        break;
+      case ParseKind::kRFC3339Full:
+      case ParseKind::kRFC3339Sec:
+        ParseRFC3339(
+            kind == ParseKind::kRFC3339Full,
+            input.size() - static_cast<std::size_t>(st->data - input.c_str()),
+            st);
+        break;
+      default:
+        ParseField(kind, st);
+        break;
+    }
+  }
+}
+
+}  // namespace
+
+// Uses strptime(3) to parse the given input.  Supports the same extended
+// format specifiers as format(), although %E#S and %E*S are treated
+// identically (and similarly for %E#f and %E*f).  %Ez and %E*z also accept
+// the same inputs. %ET accepts either 'T' or 't'.
+//
+// The standard specifiers from RFC3339_* (%Y, %m, %d, %H, %M, and %S) are
+// handled internally so that we can normally avoid strptime() altogether
+// (which is particularly helpful when the native implementation is broken).
+// The RFC3339_* layouts themselves are recognized, and their usual inputs
+// are parsed without interpreting them at all.
+//
+// The TZ/GNU %s extension is handled internally because strptime() has to
+// use localtime_r() to generate it, and that assumes the local time zone.
+//
+// We also handle the %z specifier to accommodate platforms that do not
+// support the tm_gmtoff extension to std::tm.  %Z is parsed but ignored.
+bool parse(const std::string& format, const std::string& input,
+           const time_zone& tz, time_point<seconds>* sec,
+           detail::femtoseconds* fs, std::string* err) {
+  ParseState st;
+  st.data = input.c_str();  // NUL terminated
+
+  // Skips leading whitespace.
+  ParseSpace(&st);
+
+  bool frac;
+  if (IsRFC3339(format, &frac)) {
+    ParseRFC3339(
+        frac, input.size() - static_cast<std::size_t>(st.data - input.c_str()),
+        &st);
+  } else {
+    Parser parser(&st);
+    ScanParse(format, &parser);
+  }
+  return ParseResult(&st, tz, sec, fs, err);
+}
+
+void parse_many(const parse_plan& plan, const char* const* inputs,
+                const std::size_t* sizes, std::size_t n, const time_zone& tz,
+                time_point<seconds>* secs, detail::femtoseconds* fss,
+                bool* oks) {
+  // The parser needs NUL-terminated input, so each row is copied into
+  // one buffer, which is only reallocated for a row longer than any before.
+  std::string input;
+  const time_zone utc = utc_time_zone();
+  const time_zone* const zones[2] = {&tz, &utc};
+  const std::size_t kBatchSize = 64;
+  ParsedCivil pcs[kBatchSize];
+  std::size_t rows[kBatchSize];
+  civil_second css[kBatchSize];
+  time_zone::civil_lookup cls[kBatchSize];
+  for (std::size_t i = 0; i < n; i += kBatchSize) {
+    const std::size_t batch = std::min(n - i, kBatchSize);
+    for (std::size_t j = 0; j != batch; ++j) {
+      input.assign(inputs[i + j], sizes[i + j]);
+      ParseState st;
+      ParsePlan(plan.ops_, input, &st);
+      oks[i + j] = ParseCivil(&st, &pcs[j], nullptr);
+      if (oks[i + j] && pcs[j].unix_seconds) {
+        ParseAbsolute(pcs[j], time_zone::civil_lookup(), tz, &secs[i + j],
+                      &fss[i + j], nullptr);
+      }
+    }
+    // The civil times in each zone are converted by one batch lookup,
+    // which follows the rows through the zone's transitions.
+    for (const time_zone* ptz : zones) {
+      std::size_t m = 0;
+      for (std::size_t j = 0; j != batch; ++j) {
+        if (oks[i + j] && !pcs[j].unix_seconds &&
+            pcs[j].utc == (ptz == &utc)) {
+          rows[m] = j;
+          css[m++] = pcs[j].cs;
+        }
+      }
+      if (m == 0) continue;
+      ptz->lookup(css, m, cls, nullptr);
+      for (std::size_t k = 0; k != m; ++k) {
+        const std::size_t j = rows[k];
+        oks[i + j] = ParseAbsolute(pcs[j], cls[k], *ptz, &secs[i + j],
+                                   &fss[i + j], nullptr);
+      }
+    }
+  }
+}
+
 }  // namespace detail
+
+parse_plan::parse_plan(const std::string& fmt) {
+  bool frac;
+  if (detail::IsRFC3339(fmt, &frac)) {
+    const detail::ParseKind kind =
+        frac ? detail::ParseKind::kRFC3339Full : detail::ParseKind::kRFC3339Sec;
+    ops_.push_back({static_cast<std::uint_least8_t>(kind), 0, std::string()});
+  } else {
+    detail::ParseRecorder recorder(&ops_);
+    detail::ScanParse(fmt, &recorder);
+  }
+}
+
+bool parse_plan::parse(const std::string& input, const time_zone& tz,
+                       time_point<seconds>* sec,
+                       detail::femtoseconds* fs) const {
+  detail::ParseState st;
+  detail::ParsePlan(ops_, input, &st);
+  return detail::ParseResult(&st, tz, sec, fs, nullptr);
+}
+
 }  // namespace cctz
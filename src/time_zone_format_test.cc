@@ -15,10 +15,15 @@
 #include "cctz/time_zone.h"
 
 #include <chrono>
+#include <clocale>
 #include <cstdint>
+#include <cstring>
+#include <ctime>
 #include <iomanip>
+#include <random>
 #include <sstream>
 #include <string>
+#include <vector>
 #if defined(__linux__)
 #include <features.h>
 #endif
@@ -61,6 +66,10 @@ template <typename D>
 void TestFormatSpecifier(time_point<D> tp, time_zone tz, const std::string& fmt,
                          const std::string& ans) {
   EXPECT_EQ(ans, format(fmt, tp, tz)) << fmt;
+  EXPECT_EQ(ans, format_plan(fmt).format(tp, tz)) << fmt;
+  std::string out = "xxx ";
+  EXPECT_EQ(ans.size(), format(fmt, tp, tz, &out)) << fmt;
+  EXPECT_EQ("xxx " + ans, out);
   EXPECT_EQ("xxx " + ans, format("xxx " + fmt, tp, tz));
   EXPECT_EQ(ans + " yyy", format(fmt + " yyy", tp, tz));
   EXPECT_EQ("xxx " + ans + " yyy", format("xxx " + fmt + " yyy", tp, tz));
@@ -709,6 +718,201 @@ TEST(Format, Week) {
   EXPECT_EQ("2019-52-2", format("%Y-%W-%w", tp, utc));
 }
 
+TEST(FormatPlan, MatchesFormat) {
+  const char* const kFormats[] = {
+      "",          "%",           "%%",          "%%%",
+      "%%%%",      "x%",          "%%Y",         "%%%Y",
+      "%E",        "%E4",         "%E3",         "%E*",
+      "%:",        "%::",         "%:::",        "%::::z",
+      "%Q",        "%EQ %Y",      "%E0S",        "%E0f",
+      "%E20S",     "%E3f%E*f",    "%ET%ET",      "%s %Z",
+      "%u%w%U%W",  "%e|%d",       "%Y%m%d %H%M%S",
+      "%a %A %b %B %c %y %j %p",  RFC3339_full,  RFC3339_sec,
+      RFC1123_full,               RFC1123_no_wday,
+  };
+  const time_zone utc = utc_time_zone();
+  time_zone lax;
+  EXPECT_TRUE(load_time_zone("America/Los_Angeles", &lax));
+  const time_point<chrono::nanoseconds> tps[] = {
+      chrono::system_clock::from_time_t(0),
+      chrono::system_clock::from_time_t(1420167845) +
+          chrono::nanoseconds(123456789),
+      chrono::system_clock::from_time_t(-62135596800) +  // 0001-01-01
+          chrono::nanoseconds(1),
+  };
+  for (const char* fmt : kFormats) {
+    const format_plan plan(fmt);
+    for (const time_zone& tz : {utc, lax}) {
+      for (const auto& tp : tps) {
+        EXPECT_EQ(format(fmt, tp, tz), plan.format(tp, tz)) << fmt;
+      }
+    }
+  }
+}
+
+TEST(Format, IntoBuffer) {
+  const time_zone utc = utc_time_zone();
+  const time_point<chrono::nanoseconds> tp =
+      chrono::system_clock::from_time_t(1420167845) +
+      chrono::nanoseconds(123456789);
+  const std::string fmt = "%Y-%m-%d %H:%M:%E*S %Z (%a)";
+  const std::string ans = "2015-01-02 03:04:05.123456789 UTC (Fri)";
+  const format_plan plan(fmt);
+
+  // The whole result fits, and the rest of the buffer is left alone.
+  char buf[64];
+  std::memset(buf, '#', sizeof(buf));
+  EXPECT_EQ(ans.size(), format(fmt, tp, utc, buf, sizeof(buf)));
+  EXPECT_EQ(ans, std::string(buf, ans.size()));
+  EXPECT_EQ('#', buf[ans.size()]);
+  std::memset(buf, '#', sizeof(buf));
+  EXPECT_EQ(ans.size(), plan.format(tp, utc, buf, sizeof(buf)));
+  EXPECT_EQ(ans, std::string(buf, ans.size()));
+  EXPECT_EQ('#', buf[ans.size()]);
+
+  // Truncation, at every length, still reports the full length.
+  for (std::size_t size = 0; size <= ans.size(); ++size) {
+    std::memset(buf, '#', sizeof(buf));
+    EXPECT_EQ(ans.size(), format(fmt, tp, utc, buf, size));
+    EXPECT_EQ(ans.substr(0, size), std::string(buf, size));
+    EXPECT_EQ('#', buf[size]);
+    std::memset(buf, '#', sizeof(buf));
+    EXPECT_EQ(ans.size(), plan.format(tp, utc, buf, size));
+    EXPECT_EQ(ans.substr(0, size), std::string(buf, size));
+    EXPECT_EQ('#', buf[size]);
+  }
+
+  // Appending keeps what is already there.
+  std::string out = "> ";
+  EXPECT_EQ(ans.size(), format(fmt, tp, utc, &out));
+  EXPECT_EQ(ans.size(), plan.format(tp, utc, &out));
+  EXPECT_EQ("> " + ans + ans, out);
+
+  // Long runs of strftime() specifiers, which are not copied to the stack.
+  std::string long_fmt, long_ans;
+  for (int i = 0; i != 100; ++i) {
+    long_fmt += "%a";
+    long_ans += "Fri";
+  }
+  EXPECT_EQ(long_ans, format(long_fmt, tp, utc));
+  EXPECT_EQ(long_ans, format_plan(long_fmt).format(tp, utc));
+}
+
+TEST(Format, DigitPairs) {
+  const time_zone utc = utc_time_zone();
+  EXPECT_EQ("-9223372036854775808",
+            format("%s", time_point<cctz::seconds>::min(), utc));
+  EXPECT_EQ("9223372036854775807",
+            format("%s", time_point<cctz::seconds>::max(), utc));
+
+  // Years of every length, as a field, and as part of a date.
+  for (std::int_fast64_t y = 1; y < 1000000000000; y = y * 10 + y % 7) {
+    for (const std::int_fast64_t year : {y, -y, y - 1}) {
+      const auto tp = convert(civil_second(year, 2, 3, 4, 5, 6), utc);
+      const std::string ys = std::to_string(year);
+      EXPECT_EQ(ys, format("%Y", tp, utc));
+      EXPECT_EQ(ys + "-02-03", format("%F", tp, utc));
+      EXPECT_EQ(ys + "-02-03", format("%Y-%m-%d", tp, utc));
+      EXPECT_EQ(ys + "-02-03 04:05:06", format("%Y-%m-%d %T", tp, utc));
+      EXPECT_EQ(ys + "-02-03T04:05:06+00:00", format(RFC3339_sec, tp, utc));
+    }
+  }
+
+  // Every pair of digits.
+  for (int m = 0; m != 60; ++m) {
+    const auto tp = convert(civil_second(2017, 1, 1, 0, m, 59 - m), utc);
+    std::ostringstream oss;
+    oss << std::setfill('0') << std::setw(2) << m << ":" << std::setw(2)
+        << 59 - m;
+    EXPECT_EQ("00:" + oss.str(), format("%H:%M:%S", tp, utc));
+    EXPECT_EQ("00:" + oss.str(), format("%T", tp, utc));
+  }
+}
+
+TEST(Format, NativeMatchesStrftime) {
+  // The specifiers that format() handles itself rather than by strftime(),
+  // including those that would otherwise depend on the LC_TIME locale,
+  // which is "C" here.
+  const char kFmt[] = "%a|%A|%b|%h|%B|%p|%y|%j|%D|%F|%R|%T";
+  const time_zone utc = utc_time_zone();
+  const format_plan plan(kFmt);
+  const format_plan locale_plan(kFmt, true);
+  for (const int y : {1900, 1970, 1999, 2000, 2016, 2100, 9999}) {
+    const civil_second end(y + 1, 1, 1);
+    for (civil_second cs(y, 1, 1); cs < end; cs += 7 * 3600 + 61) {
+      std::tm tm{};
+      tm.tm_year = y - 1900;
+      tm.tm_mon = cs.month() - 1;
+      tm.tm_mday = cs.day();
+      tm.tm_hour = cs.hour();
+      tm.tm_min = cs.minute();
+      tm.tm_sec = cs.second();
+      tm.tm_wday = static_cast<int>((civil_day(cs) - civil_day(1970, 1, 4)) %
+                                    7);
+      if (tm.tm_wday < 0) tm.tm_wday += 7;
+      tm.tm_yday = get_yearday(civil_day(cs)) - 1;
+      char buf[128];
+      const std::string ans(buf, std::strftime(buf, sizeof(buf), kFmt, &tm));
+      const auto tp = convert(cs, utc);
+      EXPECT_EQ(ans, format(kFmt, tp, utc)) << cs;
+      EXPECT_EQ(ans, plan.format(tp, utc)) << cs;
+      EXPECT_EQ(ans, locale_plan.format(tp, utc)) << cs;
+    }
+  }
+}
+
+TEST(Format, FollowsLocale) {
+  // format() and a locale_aware format_plan still defer to strftime() for
+  // the names when LC_TIME is neither "C" nor "POSIX". We try whichever of
+  // these locales is installed.
+  const char kFmt[] = "%a|%A|%b|%h|%B|%p|%c|%x|%X";
+  const std::string saved = std::setlocale(LC_TIME, nullptr);
+  const format_plan locale_plan(kFmt, true);
+  const time_zone utc = utc_time_zone();
+  for (const char* name : {"C.UTF-8", "en_US.UTF-8", "de_DE.UTF-8",
+                           "fr_FR.UTF-8", "ja_JP.UTF-8"}) {
+    if (std::setlocale(LC_TIME, name) == nullptr) continue;
+    for (civil_second cs(2016, 1, 1); cs < civil_second(2017, 1, 1);
+         cs += 13 * 24 * 3600 + 11 * 3600) {
+      const auto tp = convert(cs, utc);
+      const std::time_t t = chrono::system_clock::to_time_t(tp);
+      std::tm tm;
+      gmtime_r(&t, &tm);
+      char buf[256];
+      const std::string ans(buf, std::strftime(buf, sizeof(buf), kFmt, &tm));
+      EXPECT_EQ(ans, format(kFmt, tp, utc)) << name << " " << cs;
+      EXPECT_EQ(ans, locale_plan.format(tp, utc)) << name << " " << cs;
+    }
+  }
+  std::setlocale(LC_TIME, saved.c_str());
+}
+
+TEST(FormatPlan, FormatMany) {
+  time_zone lax;
+  EXPECT_TRUE(load_time_zone("America/Los_Angeles", &lax));
+  std::vector<time_point<chrono::microseconds>> tps;
+  auto tp = chrono::time_point_cast<chrono::microseconds>(
+      convert(civil_second(2013, 1, 2, 3, 4, 5), lax));
+  for (int i = 0; i != 1000; ++i) {
+    tps.push_back(tp);
+    tp += chrono::hours(i % 2 == 0 ? 37 : -11) + chrono::microseconds(i);
+  }
+  for (const char* fmt : {RFC3339_full, RFC1123_full, "", "%Y %Ez %Z"}) {
+    const format_plan plan(fmt);
+    format_arena column;
+    format_many(plan, tps.data(), 0, lax, &column);
+    EXPECT_EQ(0, column.size());
+    EXPECT_EQ(1, column.offsets.size());
+    format_many(plan, tps.data(), tps.size(), lax, &column);
+    format_many(plan, tps.data(), 3, lax, &column);  // appends
+    ASSERT_EQ(tps.size() + 3, column.size());
+    EXPECT_EQ(column.data.size(), column.offsets.back());
+    for (std::size_t i = 0; i != column.size(); ++i) {
+      EXPECT_EQ(plan.format(tps[i % tps.size()], lax), column[i]) << fmt;
+    }
+  }
+}
+
 //
 // Testing parse()
 //
@@ -1407,6 +1611,46 @@ TEST(Parse, ExtendedYears) {
   EXPECT_FALSE(parse(e4y_fmt, "100001127", utc, &tp));
 }
 
+TEST(Parse, DigitRuns) {
+  const time_zone utc = utc_time_zone();
+  time_point<cctz::seconds> tp;
+
+  // Values at and beyond the limits of a 64-bit %s.
+  EXPECT_TRUE(parse("%s", "9223372036854775807", utc, &tp));
+  EXPECT_EQ(time_point<cctz::seconds>::max(), tp);
+  EXPECT_FALSE(parse("%s", "9223372036854775808", utc, &tp));
+  EXPECT_FALSE(parse("%s", "10000000000000000000", utc, &tp));
+  EXPECT_FALSE(parse("%s", "99999999999999999999999", utc, &tp));
+  EXPECT_TRUE(parse("%s", "-9223372036854775808", utc, &tp));
+  EXPECT_EQ(time_point<cctz::seconds>::min(), tp);
+  EXPECT_FALSE(parse("%s", "-9223372036854775809", utc, &tp));
+  EXPECT_FALSE(parse("%s", "-", utc, &tp));
+  EXPECT_FALSE(parse("%s", "-00000000000000000000", utc, &tp));
+
+  // Leading zeros do not count towards the limit.
+  EXPECT_TRUE(parse("%s", "000000000000000000000000001234567890", utc, &tp));
+  EXPECT_EQ(chrono::system_clock::from_time_t(1234567890), tp);
+  EXPECT_TRUE(parse("%U %Y", "0000000000000000053 2017", utc, &tp));
+
+  // Every length of run, up to and beyond the significant digits of
+  // fractional seconds.
+  const std::string kDigits = "98765432109876543210987";
+  for (std::size_t n = 1; n <= kDigits.size(); ++n) {
+    if (n < 19) {
+      EXPECT_TRUE(parse("%s", kDigits.substr(0, n), utc, &tp)) << n;
+      EXPECT_EQ(std::stoll(kDigits.substr(0, n)),
+                tp.time_since_epoch().count());
+    }
+    detail::femtoseconds fs;
+    EXPECT_TRUE(detail::parse("%E*S", "05." + kDigits.substr(0, n), utc, &tp,
+                              &fs)) << n;
+    const std::size_t sig = n < 15 ? n : 15;
+    std::int_fast64_t want = std::stoll(kDigits.substr(0, sig));
+    for (std::size_t i = sig; i != 15; ++i) want *= 10;
+    EXPECT_EQ(want, fs.count()) << n;
+  }
+}
+
 TEST(Parse, RFC3339Format) {
   const time_zone tz = utc_time_zone();
   time_point<chrono::nanoseconds> tp;
@@ -1613,6 +1857,121 @@ TEST(Parse, TimePointOverflowFloor) {
 // Roundtrip test for format()/parse().
 //
 
+TEST(ParsePlan, MatchesParse) {
+  const struct {
+    const char* fmt;
+    const char* input;
+  } kCases[] = {
+      {RFC3339_full, "2013-06-28T19:08:09.123456-07:00"},
+      {RFC3339_full, "2013-06-28t19:08:09Z"},
+      {RFC3339_full, "2013-06-28T19:08:09.-07:00"},
+      {RFC3339_sec, " 2013-06-28T19:08:09-07:00 "},
+      {RFC3339_sec, "2013-06-28T19:08:09"},
+      {RFC1123_full, "Fri, 28 Jun 2013 19:08:09 -0700"},
+      {RFC1123_no_wday, "28 Jun 2013 19:08:09 -0700"},
+      {RFC1123_no_wday, "28 Jux 2013 19:08:09 -0700"},
+      {"%Y-%m-%d", "2013-06-28"},
+      {"%Y-%m-%d", "2013-06-31"},
+      {"%Y-%m-%d", "2013-06-28x"},
+      {"%Y  %m\t%d", "2013 06    28"},
+      {"%I:%M %p", "7:08 PM"},
+      {"%p %I:%M", "AM 12:30"},
+      {"%E4Y %U %u", "2013 25 5"},
+      {"%Y %W %w", "-2013 25 0"},
+      {"%s", "1372471689"},
+      {"%H:%M:%E3S %Z", "19:08:09.5 PDT"},
+      {"%H:%M %E*f", "19:08 5"},
+      {"%%%Y%%", "%2013%"},
+      {"%Y%", "2013"},
+      {"%:z|%::z|%:::z|%E*z", "+01:02|-03:04:05|Z|+00:00"},
+      {"%ET%H", "T19"},
+      {"%ET%H", "x19"},
+      {"lit%Yeral", "lit2013eral"},
+      {"lit%Yeral", "lit2013erai"},
+      {"", ""},
+      {"", "x"},
+  };
+  const time_zone utc = utc_time_zone();
+  time_zone lax;
+  EXPECT_TRUE(load_time_zone("America/Los_Angeles", &lax));
+  for (const auto& c : kCases) {
+    const parse_plan plan(c.fmt);
+    for (const time_zone& tz : {utc, lax}) {
+      time_point<chrono::nanoseconds> tp1, tp2;
+      const bool ok1 = parse(c.fmt, c.input, tz, &tp1);
+      const bool ok2 = plan.parse(c.input, tz, &tp2);
+      EXPECT_EQ(ok1, ok2) << c.fmt << " <- " << c.input;
+      if (ok1 && ok2) {
+        EXPECT_EQ(tp1, tp2) << c.fmt << " <- " << c.input;
+      }
+    }
+  }
+}
+
+TEST(ParsePlan, ParseMany) {
+  // Slices of one buffer, so the inputs are not NUL terminated.
+  struct Slice {
+    const char* p;
+    std::size_t n;
+    const char* data() const { return p; }
+    std::size_t size() const { return n; }
+  };
+  using sec32 = chrono::duration<std::int_least32_t>;
+  time_zone lax;
+  EXPECT_TRUE(load_time_zone("America/Los_Angeles", &lax));
+  for (const char* fmt : {RFC3339_full, "%Y-%m-%d %H:%M:%S", "%s"}) {
+    const parse_plan plan(fmt);
+    std::vector<std::string> inputs;
+    auto tp = convert(civil_second(2013, 1, 2, 3, 4, 5), lax);
+    for (int i = 0; i != 1000; ++i) {
+      if (i % 7 == 3) {
+        inputs.push_back(format(fmt, tp, lax) + "x");
+      } else if (i % 7 == 5) {
+        inputs.push_back("");
+      } else {
+        inputs.push_back(format(fmt, tp, lax));
+      }
+      // Steps through the transitions, including the repeated hours.
+      tp += chrono::hours(i % 2 == 0 ? 37 : -11) + chrono::seconds(i);
+    }
+    inputs.push_back("2013-09-31 00:00:00");
+    inputs.push_back("9999999999");  // out of range for sec32
+    const std::size_t n = inputs.size();  // not a multiple of 8
+
+    std::string buffer;
+    for (const std::string& input : inputs) buffer += input;
+    std::vector<Slice> slices;
+    std::size_t offset = 0;
+    for (const std::string& input : inputs) {
+      slices.push_back({buffer.data() + offset, input.size()});
+      offset += input.size();
+    }
+
+    std::vector<time_point<sec32>> column(n);
+    std::vector<std::uint_least8_t> errors((n + 7) / 8, 0xff);
+    const std::size_t failures =
+        parse_many(plan, slices.data(), n, lax, column.data(), errors.data());
+    EXPECT_NE(0, failures);
+    std::size_t expected_failures = 0;
+    for (std::size_t i = 0; i != n; ++i) {
+      time_point<sec32> expected;
+      const bool ok = plan.parse(inputs[i], lax, &expected);
+      if (!ok) ++expected_failures;
+      EXPECT_EQ(!ok, (errors[i / 8] >> (i % 8)) & 1)
+          << fmt << " <- " << inputs[i];
+      if (ok) {
+        EXPECT_EQ(expected, column[i]) << fmt << " <- " << inputs[i];
+      }
+    }
+    EXPECT_EQ(expected_failures, failures);
+    EXPECT_EQ(0, errors.back() >> (n % 8));  // the padding bits are clear
+    EXPECT_EQ(failures, parse_many(plan, inputs.data(), n, lax,
+                                   column.data(), nullptr));
+    EXPECT_EQ(0, parse_many(plan, inputs.data(), 0, lax, column.data(),
+                            errors.data()));
+  }
+}
+
 TEST(FormatParse, RoundTrip) {
   time_zone lax;
   EXPECT_TRUE(load_time_zone("America/Los_Angeles", &lax));
@@ -1651,6 +2010,97 @@ TEST(FormatParse, RoundTrip) {
 #endif
 }
 
+// format() and parse() handle the RFC3339 layouts without interpreting
+// them, so check them against equivalent formats that are interpreted, and
+// formatted a field at a time (as %E0f produces nothing).
+TEST(FormatParse, RFC3339MatchesGeneric) {
+  const std::string kGenericFull = "%Y%E0f-%m-%dT%H%E0f:%M:%E*S%Ez";
+  const std::string kGenericSec = "%Y%E0f-%m-%dT%H%E0f:%M:%S%Ez";
+  const std::string kParseFull = std::string(RFC3339_full) + " ";
+  const std::string kParseSec = std::string(RFC3339_sec) + " ";
+  const format_plan full_format_plan(RFC3339_full);
+  const format_plan sec_format_plan(RFC3339_sec);
+  const parse_plan full_parse_plan(RFC3339_full);
+  const parse_plan sec_parse_plan(RFC3339_sec);
+  time_zone lax;
+  EXPECT_TRUE(load_time_zone("America/Los_Angeles", &lax));
+  const time_zone tzs[] = {
+      utc_time_zone(), lax, fixed_time_zone(chrono::seconds(56)),
+      fixed_time_zone(-chrono::hours(9) - chrono::minutes(30)),
+  };
+  std::mt19937_64 rng(19);
+
+  // Formatting, with years of every length.
+  std::vector<time_point<cctz::seconds>> secs = {
+      time_point<cctz::seconds>::min(), time_point<cctz::seconds>::max(),
+  };
+  for (int i = 0; i != 2000; ++i) {
+    const int bits = static_cast<int>(rng() % 62);
+    const auto s = static_cast<std::int_fast64_t>(rng() >> (63 - bits));
+    secs.push_back(chrono::time_point_cast<cctz::seconds>(
+        std::chrono::system_clock::from_time_t(0) + cctz::seconds(s)));
+    secs.push_back(chrono::time_point_cast<cctz::seconds>(
+        std::chrono::system_clock::from_time_t(0) - cctz::seconds(s)));
+  }
+  for (const auto& tp : secs) {
+    for (const time_zone& tz : tzs) {
+      EXPECT_EQ(format(kGenericFull, tp, tz), format(RFC3339_full, tp, tz));
+      EXPECT_EQ(format(kGenericSec, tp, tz), format(RFC3339_sec, tp, tz));
+    }
+  }
+
+  // Formatting, with subseconds, and then parsing mutations of the result.
+  const char kAlphabet[] = "0123456789-+:.TtZz \t";
+  std::vector<time_point<chrono::nanoseconds>> nanos;
+  for (int i = 0; i != 2000; ++i) {
+    const auto ns = static_cast<std::int_fast64_t>(rng() >> 2);
+    const auto tp = chrono::system_clock::from_time_t(0) +
+                    chrono::nanoseconds(i % 2 == 0 ? ns : -ns);
+    nanos.push_back(tp);
+    nanos.push_back(chrono::time_point_cast<chrono::milliseconds>(tp));
+  }
+  for (const auto& tp : nanos) {
+    const time_zone& tz = tzs[rng() % 4];
+    const std::string full = format(RFC3339_full, tp, tz);
+    EXPECT_EQ(format(kGenericFull, tp, tz), full);
+    EXPECT_EQ(format(kGenericFull, tp, tz), full_format_plan.format(tp, tz));
+    EXPECT_EQ(format(kGenericSec, tp, tz), format(RFC3339_sec, tp, tz));
+    EXPECT_EQ(format(kGenericSec, tp, tz), sec_format_plan.format(tp, tz));
+
+    std::string input = (rng() % 2 == 0) ? full : format(RFC3339_sec, tp, tz);
+    switch (rng() % 5) {
+      case 0:
+        break;
+      case 1:
+        input[rng() % input.size()] = kAlphabet[rng() % sizeof(kAlphabet)];
+        break;
+      case 2:
+        input.erase(rng() % input.size(), 1);
+        break;
+      case 3:
+        input.insert(rng() % (input.size() + 1), 1,
+                     kAlphabet[rng() % sizeof(kAlphabet)]);
+        break;
+      case 4:
+        input.resize(rng() % input.size());
+        break;
+    }
+    const time_zone& ptz = tzs[rng() % 4];
+    time_point<chrono::nanoseconds> want_full{}, got_full{}, plan_full{};
+    const bool ok_full = parse(kParseFull, input, ptz, &want_full);
+    EXPECT_EQ(ok_full, parse(RFC3339_full, input, ptz, &got_full)) << input;
+    EXPECT_EQ(ok_full, full_parse_plan.parse(input, ptz, &plan_full));
+    EXPECT_EQ(want_full, got_full) << input;
+    EXPECT_EQ(want_full, plan_full) << input;
+    time_point<chrono::nanoseconds> want_sec{}, got_sec{}, plan_sec{};
+    const bool ok_sec = parse(kParseSec, input, ptz, &want_sec);
+    EXPECT_EQ(ok_sec, parse(RFC3339_sec, input, ptz, &got_sec)) << input;
+    EXPECT_EQ(ok_sec, sec_parse_plan.parse(input, ptz, &plan_sec));
+    EXPECT_EQ(want_sec, got_sec) << input;
+    EXPECT_EQ(want_sec, plan_sec) << input;
+  }
+}
+
 TEST(FormatParse, RoundTripDistantFuture) {
   const time_zone utc = utc_time_zone();
   const time_point<cctz::seconds> in = time_point<cctz::seconds>::max();
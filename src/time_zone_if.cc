@@ -13,18 +13,34 @@
 //   limitations under the License.
 
 #include "time_zone_if.h"
+
+#include <cstdint>
+#include <limits>
+
+#include "time_zone_fixed.h"
 #include "time_zone_info.h"
 #include "time_zone_libc.h"
 
 namespace cctz {
 
-std::unique_ptr<TimeZoneIf> TimeZoneIf::Load(const std::string& name) {
+std::unique_ptr<TimeZoneIf> TimeZoneIf::Load(const std::string& name,
+                                             const TimeZoneFixed** fixed) {
+  *fixed = nullptr;
+
   // Support "libc:localtime" and "libc:*" to access the legacy
   // localtime and UTC support respectively from the C library.
   if (name.compare(0, 5, "libc:") == 0) {
     return std::unique_ptr<TimeZoneIf>(new TimeZoneLibC(name.substr(5)));
   }
 
+  // Fixed-offset zones, including UTC, need no zoneinfo.
+  auto offset = seconds::zero();
+  if (FixedOffsetFromName(name, &offset)) {
+    auto* tz = new TimeZoneFixed(offset);
+    *fixed = tz;
+    return std::unique_ptr<TimeZoneIf>(tz);
+  }
+
   // Otherwise use the "zoneinfo" implementation by default.
   std::unique_ptr<TimeZoneInfo> tz(new TimeZoneInfo);
   if (!tz->Load(name)) tz.reset();
@@ -34,4 +50,71 @@ std::unique_ptr<TimeZoneIf> TimeZoneIf::Load(const std::string& name) {
 // Defined out-of-line to avoid emitting a weak vtable in all TUs.
 TimeZoneIf::~TimeZoneIf() {}
 
+// The default batch conversion simply breaks down each time in turn.
+// Subclasses may override this to exploit locality between elements.
+void TimeZoneIf::BreakTimes(const time_point<seconds>* tps, std::size_t n,
+                            time_zone::absolute_lookup* als) const {
+  for (std::size_t i = 0; i != n; ++i) als[i] = BreakTime(tps[i]);
+}
+
+// The default span is just the given time, as we know nothing of when the
+// offset changes, so that each cursor lookup will defer to BreakTime().
+time_zone::absolute_lookup TimeZoneIf::BreakTimeSpan(
+    const time_point<seconds>& tp, std::size_t* /*hint*/,
+    time_point<seconds>* first, time_point<seconds>* last) const {
+  *first = *last = tp;
+  return BreakTime(tp);
+}
+
+void TimeZoneIf::AppendRun(std::int_fast64_t unix_start,
+                           std::int_fast32_t utc_offset, bool is_dst,
+                           const char* abbr,
+                           time_zone::offset_schedule* sched) {
+  std::size_t abbr_id = 0;
+  while (abbr_id != sched->abbrs.size() && sched->abbrs[abbr_id] != abbr) {
+    ++abbr_id;
+  }
+  if (abbr_id == sched->abbrs.size()) sched->abbrs.push_back(abbr);
+  if (!sched->runs.empty()) {
+    const time_zone::offset_run& last = sched->runs.back();
+    if (last.utc_offset == utc_offset && last.is_dst == is_dst &&
+        last.abbr_id == abbr_id) {
+      return;  // no change
+    }
+  }
+  time_zone::offset_run run;
+  run.unix_start = unix_start;
+  run.utc_offset = static_cast<std::int_least32_t>(utc_offset);
+  run.is_dst = is_dst;
+  run.abbr_id = static_cast<std::uint_least8_t>(abbr_id);
+  sched->runs.push_back(run);
+}
+
+// The default schedule is found by enumerating the transitions, starting
+// with the last one at or before "from" (if any).
+void TimeZoneIf::Schedule(const time_point<seconds>& from,
+                          const time_point<seconds>& to,
+                          time_zone::offset_schedule* sched) const {
+  std::int_fast64_t unix_start = std::numeric_limits<std::int_fast64_t>::min();
+  time_zone::civil_transition trans;
+  if (from != time_point<seconds>::max() &&
+      PrevTransition(from + seconds(1), &trans)) {
+    unix_start = ToUnixSeconds(MakeTime(trans.to).trans);
+  }
+  time_zone::absolute_lookup al = BreakTime(from);
+  AppendRun(unix_start, al.offset, al.is_dst, al.abbr, sched);
+  for (time_point<seconds> tp = from; tp < to && NextTransition(tp, &trans);) {
+    tp = MakeTime(trans.to).trans;
+    if (tp > to) break;
+    al = BreakTime(tp);
+    AppendRun(ToUnixSeconds(tp), al.offset, al.is_dst, al.abbr, sched);
+  }
+}
+
+// Similarly, the default batch conversion of civil times makes each in turn.
+void TimeZoneIf::MakeTimes(const civil_second* cs, std::size_t n,
+                           time_zone::civil_lookup* cls) const {
+  for (std::size_t i = 0; i != n; ++i) cls[i] = MakeTime(cs[i]);
+}
+
 }  // namespace cctz
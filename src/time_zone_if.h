@@ -16,6 +16,7 @@
 #define CCTZ_TIME_ZONE_IF_H_
 
 #include <chrono>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -25,30 +26,50 @@
 
 namespace cctz {
 
+class TimeZoneFixed;
+
 // A simple interface used to hide time-zone complexities from time_zone::Impl.
 // Subclasses implement the functions for civil-time conversions in the zone.
 class TimeZoneIf {
  public:
-  // A factory function for TimeZoneIf implementations.
-  static std::unique_ptr<TimeZoneIf> Load(const std::string& name);
+  // A factory function for TimeZoneIf implementations. *fixed is set to
+  // the result when it is a TimeZoneFixed, and to nullptr otherwise.
+  static std::unique_ptr<TimeZoneIf> Load(const std::string& name,
+                                          const TimeZoneFixed** fixed);
 
   virtual ~TimeZoneIf();
 
   virtual time_zone::absolute_lookup BreakTime(
       const time_point<seconds>& tp) const = 0;
+  virtual void BreakTimes(const time_point<seconds>* tps, std::size_t n,
+                          time_zone::absolute_lookup* als) const;
+  virtual time_zone::absolute_lookup BreakTimeSpan(
+      const time_point<seconds>& tp, std::size_t* hint,
+      time_point<seconds>* first, time_point<seconds>* last) const;
   virtual time_zone::civil_lookup MakeTime(
       const civil_second& cs) const = 0;
+  virtual void MakeTimes(const civil_second* cs, std::size_t n,
+                         time_zone::civil_lookup* cls) const;
 
   virtual bool NextTransition(const time_point<seconds>& tp,
                               time_zone::civil_transition* trans) const = 0;
   virtual bool PrevTransition(const time_point<seconds>& tp,
                               time_zone::civil_transition* trans) const = 0;
 
+  virtual void Schedule(const time_point<seconds>& from,
+                        const time_point<seconds>& to,
+                        time_zone::offset_schedule* sched) const;
+
   virtual std::string Version() const = 0;
   virtual std::string Description() const = 0;
 
  protected:
   TimeZoneIf() {}
+
+  // Adds a run to a schedule, unless it is the same as the last run.
+  static void AppendRun(std::int_fast64_t unix_start,
+                        std::int_fast32_t utc_offset, bool is_dst,
+                        const char* abbr, time_zone::offset_schedule* sched);
 };
 
 // Convert between time_point<seconds> and a count of seconds since the
@@ -64,6 +85,37 @@ inline time_point<seconds> FromUnixSeconds(std::int_fast64_t t) {
              std::chrono::system_clock::from_time_t(0)) + seconds(t);
 }
 
+// Convert a count of seconds since the Unix epoch to the civil time at the
+// given offset from UTC. This is the same as (civil_second() + unix_time) +
+// utc_offset, but it splits the count into days and seconds directly, and
+// so avoids carrying through the minutes and hours.
+inline civil_second UnixToCivil(std::int_fast64_t unix_time,
+                                std::int_fast32_t utc_offset) {
+  const std::int_fast64_t kSecsPerDay = 24 * 60 * 60;
+  std::int_fast64_t days = unix_time / kSecsPerDay;
+  std::int_fast64_t secs = unix_time % kSecsPerDay + utc_offset;
+  if (secs < 0) {
+    secs += kSecsPerDay;
+    days -= 1;
+    if (secs < 0) {
+      secs += kSecsPerDay;
+      days -= 1;
+    }
+  } else if (secs >= kSecsPerDay) {
+    secs -= kSecsPerDay;
+    days += 1;
+    if (secs >= kSecsPerDay) {
+      secs -= kSecsPerDay;
+      days += 1;
+    }
+  }
+  const detail::fields f = detail::impl::ord_ymd(
+      days, static_cast<detail::hour_t>(secs / 3600),
+      static_cast<detail::minute_t>(secs / 60 % 60),
+      static_cast<detail::second_t>(secs % 60));
+  return civil_second(f.y, f.m, f.d, f.hh, f.mm, f.ss);
+}
+
 }  // namespace cctz
 
 #endif  // CCTZ_TIME_ZONE_IF_H_
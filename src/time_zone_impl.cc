@@ -14,11 +14,13 @@
 
 #include "time_zone_impl.h"
 
+#include <atomic>
+#include <cstddef>
 #include <deque>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <string>
-#include <unordered_map>
 #include <utility>
 
 #include "time_zone_fixed.h"
@@ -28,11 +30,62 @@ namespace cctz {
 namespace {
 
 // time_zone::Impls are linked into a map to support fast lookup by name.
-using TimeZoneImplByName =
-    std::unordered_map<std::string, const time_zone::Impl*>;
-TimeZoneImplByName* time_zone_map = nullptr;
+// The map is a fixed-size hash table of singly-linked entry chains. Entries
+// are immutable once published, and are never removed, so readers search
+// the chains without locking, while writers serialize on TimeZoneMutex()
+// and publish new chain heads using release stores.
+struct TimeZoneEntry {
+  TimeZoneEntry(const std::string& n, const time_zone::Impl* i,
+                const TimeZoneEntry* nx)
+      : name(n), impl(i), next(nx) {}
+
+  const std::string name;
+  const time_zone::Impl* const impl;
+  const TimeZoneEntry* const next;
+};
+
+class TimeZoneImplByName {
+ public:
+  TimeZoneImplByName() {
+    for (auto& bucket : buckets_) {
+      bucket.store(nullptr, std::memory_order_relaxed);
+    }
+  }
+  TimeZoneImplByName(const TimeZoneImplByName&) = delete;
+  TimeZoneImplByName& operator=(const TimeZoneImplByName&) = delete;
+
+  // Returns the Impl for the named zone, or nullptr if it is not present.
+  // Safe to call concurrently with Insert().
+  const time_zone::Impl* Find(const std::string& name) const {
+    const TimeZoneEntry* entry =
+        buckets_[Bucket(name)].load(std::memory_order_acquire);
+    for (; entry != nullptr; entry = entry->next) {
+      if (entry->name == name) return entry->impl;
+    }
+    return nullptr;
+  }
+
+  // Adds an Impl for a zone that is not yet present. The caller must
+  // hold TimeZoneMutex().
+  void Insert(const std::string& name, const time_zone::Impl* impl) {
+    std::atomic<const TimeZoneEntry*>& head = buckets_[Bucket(name)];
+    const TimeZoneEntry* next = head.load(std::memory_order_relaxed);
+    head.store(new TimeZoneEntry(name, impl, next), std::memory_order_release);
+  }
+
+ private:
+  static const std::size_t kBuckets = 1024;  // ~600 zones in the database
 
-// Mutual exclusion for time_zone_map.
+  static std::size_t Bucket(const std::string& name) {
+    return std::hash<std::string>()(name) % kBuckets;
+  }
+
+  std::atomic<const TimeZoneEntry*> buckets_[kBuckets];
+};
+
+std::atomic<TimeZoneImplByName*> time_zone_map(nullptr);
+
+// Mutual exclusion for updates to time_zone_map.
 std::mutex& TimeZoneMutex() {
   // This mutex is intentionally "leaked" to avoid the static deinitialization
   // order fiasco (std::mutex's destructor is not trivial on many platforms).
@@ -56,15 +109,11 @@ bool time_zone::Impl::LoadTimeZone(const std::string& name, time_zone* tz) {
     return true;
   }
 
-  // Check whether the time zone has already been loaded.
-  {
-    std::lock_guard<std::mutex> lock(TimeZoneMutex());
-    if (time_zone_map != nullptr) {
-      TimeZoneImplByName::const_iterator itr = time_zone_map->find(name);
-      if (itr != time_zone_map->end()) {
-        *tz = time_zone(itr->second);
-        return itr->second != utc_impl;
-      }
+  // Check whether the time zone has already been loaded (without locking).
+  if (const auto* map = time_zone_map.load(std::memory_order_acquire)) {
+    if (const Impl* impl = map->Find(name)) {
+      *tz = time_zone(impl);
+      return impl != utc_impl;
     }
   }
 
@@ -73,10 +122,15 @@ bool time_zone::Impl::LoadTimeZone(const std::string& name, time_zone* tz) {
 
   // Add the new time zone to the map.
   std::lock_guard<std::mutex> lock(TimeZoneMutex());
-  if (time_zone_map == nullptr) time_zone_map = new TimeZoneImplByName;
-  const Impl*& impl = (*time_zone_map)[name];
+  auto* map = time_zone_map.load(std::memory_order_relaxed);
+  if (map == nullptr) {
+    map = new TimeZoneImplByName;
+    time_zone_map.store(map, std::memory_order_release);
+  }
+  const Impl* impl = map->Find(name);
   if (impl == nullptr) {  // this thread won any load race
     impl = new_impl->zone_ ? new_impl.release() : utc_impl;
+    map->Insert(name, impl);
   }
   *tz = time_zone(impl);
   return impl != utc_impl;
@@ -84,21 +138,22 @@ bool time_zone::Impl::LoadTimeZone(const std::string& name, time_zone* tz) {
 
 void time_zone::Impl::ClearTimeZoneMapTestOnly() {
   std::lock_guard<std::mutex> lock(TimeZoneMutex());
-  if (time_zone_map != nullptr) {
-    // Existing time_zone::Impl* entries are in the wild, so we can't delete
-    // them. Instead, we move them to a private container, where they are
-    // logically unreachable but not "leaked".  Future requests will result
-    // in reloading the data.
-    static auto* cleared = new std::deque<const time_zone::Impl*>;
-    for (const auto& element : *time_zone_map) {
-      cleared->push_back(element.second);
-    }
-    time_zone_map->clear();
+  if (auto* map = time_zone_map.load(std::memory_order_relaxed)) {
+    // Existing time_zone::Impl* entries are in the wild, and other threads
+    // may still be searching the map, so we can't delete either. Instead,
+    // we move the map to a private container, where it is logically
+    // unreachable but not "leaked".  Future requests will result in
+    // reloading the data.
+    static auto* cleared = new std::deque<const TimeZoneImplByName*>;
+    cleared->push_back(map);
+    time_zone_map.store(nullptr, std::memory_order_release);
   }
 }
 
 time_zone::Impl::Impl(const std::string& name)
-    : name_(name), zone_(TimeZoneIf::Load(name_)) {}
+    : name_(name), fixed_(nullptr) {
+  zone_ = TimeZoneIf::Load(name_, &fixed_);
+}
 
 const time_zone::Impl* time_zone::Impl::UTCImpl() {
   static const Impl* utc_impl = new Impl("UTC");  // never fails
@@ -15,11 +15,13 @@
 #ifndef CCTZ_TIME_ZONE_IMPL_H_
 #define CCTZ_TIME_ZONE_IMPL_H_
 
+#include <cstddef>
 #include <memory>
 #include <string>
 
 #include "cctz/civil_time.h"
 #include "cctz/time_zone.h"
+#include "time_zone_fixed.h"
 #include "time_zone_if.h"
 #include "time_zone_info.h"
 
@@ -47,16 +49,50 @@ class time_zone::Impl {
 
   // Breaks a time_point down to civil-time components in this time zone.
   time_zone::absolute_lookup BreakTime(const time_point<seconds>& tp) const {
+    if (fixed_ != nullptr) return fixed_->BreakTime(tp);  // no virtual call
     return zone_->BreakTime(tp);
   }
 
+  // Breaks down a batch of time_points, as if by BreakTime() on each.
+  void BreakTimes(const time_point<seconds>* tps, std::size_t n,
+                  time_zone::absolute_lookup* als) const {
+    zone_->BreakTimes(tps, n, als);
+  }
+
+  // Breaks down a time_point, as BreakTime() does, while also finding the
+  // span of times [*first, *last] around it over which the offset (and
+  // so the rest of the breakdown, but for the civil time) stays the same.
+  // *hint is kept by the caller between calls, and lets the search begin
+  // from the position of the previous span.
+  time_zone::absolute_lookup BreakTimeSpan(const time_point<seconds>& tp,
+                                           std::size_t* hint,
+                                           time_point<seconds>* first,
+                                           time_point<seconds>* last) const {
+    return zone_->BreakTimeSpan(tp, hint, first, last);
+  }
+
   // Converts the civil-time components in this time zone into a time_point.
   // That is, the opposite of BreakTime(). The requested civil time may be
   // ambiguous or illegal due to a change of UTC offset.
   time_zone::civil_lookup MakeTime(const civil_second& cs) const {
+    if (fixed_ != nullptr) return fixed_->MakeTime(cs);  // no virtual call
     return zone_->MakeTime(cs);
   }
 
+  // Makes a batch of civil times, as if by MakeTime() on each.
+  void MakeTimes(const civil_second* cs, std::size_t n,
+                 time_zone::civil_lookup* cls) const {
+    zone_->MakeTimes(cs, n, cls);
+  }
+
+  // Describes the offsets in this time zone over [from, to].
+  time_zone::offset_schedule Schedule(const time_point<seconds>& from,
+                                      const time_point<seconds>& to) const {
+    time_zone::offset_schedule sched;
+    zone_->Schedule(from, to, &sched);
+    return sched;
+  }
+
   // Finds the time of the next/previous offset change in this time zone.
   bool NextTransition(const time_point<seconds>& tp,
                       time_zone::civil_transition* trans) const {
@@ -79,6 +115,7 @@ class time_zone::Impl {
 
   const std::string name_;
   std::unique_ptr<TimeZoneIf> zone_;
+  const TimeZoneFixed* fixed_;  // zone_, when it is a fixed offset
 };
 
 }  // namespace cctz
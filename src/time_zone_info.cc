@@ -32,15 +32,25 @@
 
 #include "time_zone_info.h"
 
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define CCTZ_HAVE_MMAP 1
+#endif
+
 #include <algorithm>
 #include <cassert>
 #include <chrono>
+#include <cstddef>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <fstream>
 #include <functional>
+#include <limits>
 #include <memory>
 #include <sstream>
 #include <string>
@@ -49,6 +59,9 @@
 #include "cctz/civil_time.h"
 #include "time_zone_fixed.h"
 #include "time_zone_posix.h"
+#include "time_zone_search.h"
+#include "zone_bundle.h"
+#include "zone_info_memory.h"
 
 namespace cctz {
 
@@ -71,8 +84,15 @@ const std::int_least16_t kMonthOffsets[2][1 + 12 + 1] = {
 // We reject leap-second encoded zoneinfo and so assume 60-second minutes.
 const std::int_least32_t kSecsPerDay = 24 * 60 * 60;
 
-// 400-year chunks always have 146097 days (20871 weeks).
-const std::int_least64_t kSecsPer400Years = 146097LL * kSecsPerDay;
+// The range of supported transition times, the lower limit of which is the
+// "first half" transition added by Load(). Keeping transitions within this
+// range lets us represent their local civil times as a count of seconds
+// since civil_second() without worry of overflow. Civil times in years
+// outside the matching year range then lie beyond all transitions.
+const std::int_least64_t kMinTransitionTime = -(1LL << 59);
+const std::int_least64_t kMaxTransitionTime = (1LL << 59);
+const year_t kMinTransitionYear = -20000000000LL;  // < -18267312070
+const year_t kMaxTransitionYear = 20000000000LL;   // > 18267315989
 
 // Like kDaysPerYear[] but scaled up by a factor of kSecsPerDay.
 const std::int_least32_t kSecsPerYear[2] = {
@@ -130,6 +150,30 @@ std::int_fast64_t Decode64(const char* cp) {
   return static_cast<std::int_fast64_t>(v - s64maxU - 1) - s64max - 1;
 }
 
+// Returns a pointer to the next size bytes of a source whose data resides
+// in memory, advancing past them, or else nullptr, in which case they
+// should be read as usual.
+const char* ReadInPlace(ZoneInfoSource* zip, std::size_t size) {
+  auto* mzip = MemoryZoneInfoSource::From(zip);
+  return (mzip != nullptr) ? mzip->ReadInPlace(size) : nullptr;
+}
+
+// The inverses of Decode32() and Decode64(), which append the encoding
+// of the given value to *out.
+void Encode32(std::int_fast32_t value, std::string* out) {
+  const auto v = static_cast<std::uint_fast32_t>(value);
+  for (int i = (32 / 8); i-- != 0;) {
+    out->push_back(static_cast<char>((v >> (8 * i)) & 0xff));
+  }
+}
+
+void Encode64(std::int_fast64_t value, std::string* out) {
+  const auto v = static_cast<std::uint_fast64_t>(value);
+  for (int i = (64 / 8); i-- != 0;) {
+    out->push_back(static_cast<char>((v >> (8 * i)) & 0xff));
+  }
+}
+
 // Does the rule for future transitions call for year-round daylight time?
 // See tz/zic.c:stringzone() for the details on how such rules are encoded.
 bool AllYearDST(const PosixTimeZone& posix) {
@@ -175,6 +219,30 @@ std::int_fast64_t TransOffset(bool leap_year, int jan1_weekday,
   return (days * kSecsPerDay) + pt.time.offset;
 }
 
+// The number of years of transitions that ExtendTransitions() generates
+// from the future specification, out of the 400 needed for the shift to
+// cycle-equivalent years. Setting ${CCTZ_EXTENSION_YEARS} to fewer years
+// saves the memory and load time for the remainder, whose transitions are
+// then computed on demand (more slowly) when a lookup falls among them.
+year_t ExtensionYears() {
+  year_t years = 400;
+  char* years_env = nullptr;
+#if defined(_MSC_VER)
+  _dupenv_s(&years_env, nullptr, "CCTZ_EXTENSION_YEARS");
+#else
+  years_env = std::getenv("CCTZ_EXTENSION_YEARS");
+#endif
+  if (years_env && *years_env) {
+    char* ep = nullptr;
+    const long n = std::strtol(years_env, &ep, 10);
+    if (*ep == '\0' && 1 <= n && n < 400) years = n;
+  }
+#if defined(_MSC_VER)
+  free(years_env);
+#endif
+  return years;
+}
+
 inline time_zone::civil_lookup MakeUnique(const time_point<seconds>& tp) {
   time_zone::civil_lookup cl;
   cl.kind = time_zone::civil_lookup::UNIQUE;
@@ -186,29 +254,136 @@ inline time_zone::civil_lookup MakeUnique(std::int_fast64_t unix_time) {
   return MakeUnique(FromUnixSeconds(unix_time));
 }
 
-inline time_zone::civil_lookup MakeSkipped(const Transition& tr,
-                                           const civil_second& cs) {
+// The civil_lookup for a civil time cs that is skipped or repeated by the
+// transition at unix_time, where all the civil times are represented as
+// seconds since civil_second().
+inline time_zone::civil_lookup MakeSkipped(std::int_fast64_t unix_time,
+                                           std::int_fast64_t civil_sec,
+                                           std::int_fast64_t prev_civil_sec,
+                                           std::int_fast64_t cs) {
   time_zone::civil_lookup cl;
   cl.kind = time_zone::civil_lookup::SKIPPED;
-  cl.pre = FromUnixSeconds(tr.unix_time - 1 + (cs - tr.prev_civil_sec));
-  cl.trans = FromUnixSeconds(tr.unix_time);
-  cl.post = FromUnixSeconds(tr.unix_time - (tr.civil_sec - cs));
+  cl.pre = FromUnixSeconds(unix_time - 1 + (cs - prev_civil_sec));
+  cl.trans = FromUnixSeconds(unix_time);
+  cl.post = FromUnixSeconds(unix_time - (civil_sec - cs));
   return cl;
 }
 
-inline time_zone::civil_lookup MakeRepeated(const Transition& tr,
-                                            const civil_second& cs) {
+inline time_zone::civil_lookup MakeRepeated(std::int_fast64_t unix_time,
+                                            std::int_fast64_t civil_sec,
+                                            std::int_fast64_t prev_civil_sec,
+                                            std::int_fast64_t cs) {
   time_zone::civil_lookup cl;
   cl.kind = time_zone::civil_lookup::REPEATED;
-  cl.pre = FromUnixSeconds(tr.unix_time - 1 - (tr.prev_civil_sec - cs));
-  cl.trans = FromUnixSeconds(tr.unix_time);
-  cl.post = FromUnixSeconds(tr.unix_time + (cs - tr.civil_sec));
+  cl.pre = FromUnixSeconds(unix_time - 1 - (prev_civil_sec - cs));
+  cl.trans = FromUnixSeconds(unix_time);
+  cl.post = FromUnixSeconds(unix_time + (cs - civil_sec));
   return cl;
 }
 
-inline civil_second YearShift(const civil_second& cs, year_t shift) {
-  return civil_second(cs.year() + shift, cs.month(), cs.day(),
-                      cs.hour(), cs.minute(), cs.second());
+// The time_point<seconds> at which the civil time cs occurs under the
+// given transition type, saturating when that is out of range.
+inline time_point<seconds> TimeAt(const civil_second& cs,
+                                  const TransitionType& tt) {
+  if (cs > tt.civil_max) return time_point<seconds>::max();
+  if (cs < tt.civil_min) return time_point<seconds>::min();
+  return FromUnixSeconds(cs - (civil_second() + tt.utc_offset));
+}
+
+// The number of days from 1970-01-01 to the given date, using Howard
+// Hinnant's days_from_civil() algorithm. The year must be small enough
+// that the result does not overflow (callers use cycle-equivalent years).
+inline std::int_fast64_t DaysFromCivil(year_t y, int m, int d) {
+  y -= (m <= 2 ? 1 : 0);
+  const year_t era = (y >= 0 ? y : y - 399) / 400;
+  const std::int_fast64_t yoe = y - era * 400;  // [0, 399]
+  const std::int_fast64_t doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+  const std::int_fast64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + doe - 719468;
+}
+
+// A year in [2400, 2800) with the same calendar as the given year, as
+// the Gregorian calendar repeats every 400 years (146097 days, which is
+// a whole number of weeks).
+inline year_t CycleYear(year_t year) {
+  const year_t y = year % 400;
+  return 2400 + (y < 0 ? y + 400 : y);
+}
+
+// The final year of the rule transitions that Schedule() reports.
+const year_t kMaxScheduleYear = 9999;
+
+// The number of seconds from the start of its year to the civil time.
+inline std::int_fast64_t SecondsInYear(const civil_second& cs) {
+  const year_t year = CycleYear(cs.year());
+  const std::int_fast64_t days =
+      DaysFromCivil(year, cs.month(), cs.day()) - DaysFromCivil(year, 1, 1);
+  return ((days * 24 + cs.hour()) * 60 + cs.minute()) * 60 + cs.second();
+}
+
+// The transitions found by the last BreakTime() and MakeTime() calls on a
+// zone, as the indexes of the first transitions after their targets. If
+// the next request is for the same transition we avoid re-searching. Any
+// index is safe, as each is validated before it is used.
+struct LookupHints {
+  const TimeZoneInfo* zone;
+  std::size_t local_time;  // BreakTime() hint
+  std::size_t time_local;  // MakeTime() hint
+};
+
+// See TimeZoneInfo::ThreadHintStatsTestOnly().
+thread_local TimeZoneInfo::HintStats thread_hint_stats = {0, 0};
+
+// Returns the calling thread's hints for the zone. Rather than sharing one
+// hint per zone, which threads converting times from different eras would
+// keep overwriting (while bouncing its cache line between cores), each
+// thread keeps its own, in a small direct-mapped cache keyed by the zone.
+// A zone that collides with another merely loses its hints.
+LookupHints& ThreadHints(const TimeZoneInfo* zone) {
+  constexpr std::size_t kHintSlots = 8;
+  static thread_local LookupHints hints[kHintSlots];
+  const std::uintptr_t addr = reinterpret_cast<std::uintptr_t>(zone);
+  LookupHints& h = hints[addr / sizeof(TimeZoneInfo) % kHintSlots];
+  if (h.zone != zone) {
+    h.zone = zone;
+    h.local_time = 0;
+    h.time_local = 0;
+  }
+  return h;
+}
+
+// Returns the first key in (begin, end) that is greater than the target,
+// like std::upper_bound(), given that one exists (that is, that begin[0] <=
+// target < end[-1]). The search gallops from tr, a previous such result,
+// in the appropriate direction, so it is much faster than a full binary
+// search when the target is near tr.
+const std::int_least64_t* UpperBoundFrom(const std::int_least64_t* begin,
+                                         const std::int_least64_t* end,
+                                         const std::int_least64_t* tr,
+                                         std::int_fast64_t target) {
+  if (*tr <= target) {
+    // Gallop forwards, maintaining *lo <= target.
+    const std::int_least64_t* lo = tr;
+    std::ptrdiff_t step = 1;
+    while (step < end - lo && lo[step] <= target) {
+      lo += step;
+      step *= 2;
+    }
+    const std::int_least64_t* hi = (step < end - lo) ? lo + step : end;
+    return std::upper_bound(lo + 1, hi, target);
+  }
+  if (target < tr[-1]) {
+    // Gallop backwards, maintaining target < hi[-1].
+    const std::int_least64_t* hi = tr;
+    std::ptrdiff_t step = 1;
+    while (step < hi - begin && target < hi[-step - 1]) {
+      hi -= step;
+      step *= 2;
+    }
+    const std::int_least64_t* lo = (step < hi - begin) ? hi - step - 1 : begin;
+    return std::upper_bound(lo, hi - 1, target);
+  }
+  return tr;
 }
 
 }  // namespace
@@ -224,8 +399,8 @@ bool TimeZoneInfo::ResetToBuiltinUTC(const seconds& offset) {
   // We temporarily add some redundant, contemporary (2015 through 2025)
   // transitions for performance reasons.  See TimeZoneInfo::LocalTime().
   // TODO: Fix the performance issue and remove the extra transitions.
-  transitions_.clear();
-  transitions_.reserve(12);
+  trans_unix_time_.clear();
+  trans_type_index_.clear();
   for (const std::int_fast64_t unix_time : {
            -(1LL << 59),  // a "first half" transition
            1420070400LL,  // 2015-01-01T00:00:00+00:00
@@ -240,11 +415,8 @@ bool TimeZoneInfo::ResetToBuiltinUTC(const seconds& offset) {
            1704067200LL,  // 2024-01-01T00:00:00+00:00
            1735689600LL,  // 2025-01-01T00:00:00+00:00
        }) {
-    Transition& tr(*transitions_.emplace(transitions_.end()));
-    tr.unix_time = unix_time;
-    tr.type_index = 0;
-    tr.civil_sec = LocalTime(tr.unix_time, tt).cs;
-    tr.prev_civil_sec = tr.civil_sec - 1;
+    trans_unix_time_.push_back(unix_time);
+    trans_type_index_.push_back(0);
   }
 
   default_transition_type_ = 0;
@@ -252,12 +424,9 @@ bool TimeZoneInfo::ResetToBuiltinUTC(const seconds& offset) {
   abbreviations_.append(1, '\0');
   future_spec_.clear();  // never needed for a fixed-offset zone
   extended_ = false;
+  lazy_years_ = 0;
 
-  tt.civil_max = LocalTime(seconds::max().count(), tt).cs;
-  tt.civil_min = LocalTime(seconds::min().count(), tt).cs;
-
-  transitions_.shrink_to_fit();
-  return true;
+  return ComputeCivilTimes();
 }
 
 // Builds the in-memory header using the raw bytes from the file.
@@ -341,6 +510,7 @@ bool TimeZoneInfo::GetTransitionType(std::int_fast32_t utc_offset, bool is_dst,
 // in years after the last transition stored in the zoneinfo data.
 bool TimeZoneInfo::ExtendTransitions() {
   extended_ = false;
+  lazy_years_ = 0;
   if (future_spec_.empty()) return true;  // last transition prevails
 
   PosixTimeZone posix;
@@ -354,7 +524,7 @@ bool TimeZoneInfo::ExtendTransitions() {
   if (posix.dst_abbr.empty()) {  // std only
     // The future specification should match the last transition, and
     // that means that handling the future will fall out naturally.
-    return EquivTransitions(transitions_.back().type_index, std_ti);
+    return EquivTransitions(trans_type_index_.back(), std_ti);
   }
 
   // Find transition type for the future dst specification.
@@ -365,37 +535,44 @@ bool TimeZoneInfo::ExtendTransitions() {
   if (AllYearDST(posix)) {  // dst only
     // The future specification should match the last transition, and
     // that means that handling the future will fall out naturally.
-    return EquivTransitions(transitions_.back().type_index, dst_ti);
+    return EquivTransitions(trans_type_index_.back(), dst_ti);
   }
 
   // Extend the transitions for an additional 400 years using the
   // future specification. Years beyond those can be handled by
   // mapping back to a cycle-equivalent year within that range.
   // We may need two additional transitions for the current year.
-  transitions_.reserve(transitions_.size() + 400 * 2 + 2);
+  // When extending lazily we only generate the first years of those.
+  const year_t years = ExtensionYears();
+  trans_unix_time_.reserve(trans_unix_time_.size() + years * 2 + 2);
+  trans_type_index_.reserve(trans_type_index_.size() + years * 2 + 2);
   extended_ = true;
 
-  const Transition& last(transitions_.back());
-  const std::int_fast64_t last_time = last.unix_time;
-  const TransitionType& last_tt(transition_types_[last.type_index]);
+  const std::int_fast64_t last_time = trans_unix_time_.back();
+  const TransitionType& last_tt(transition_types_[trans_type_index_.back()]);
   last_year_ = LocalTime(last_time, last_tt).cs.year();
   bool leap_year = IsLeap(last_year_);
   const civil_second jan1(last_year_);
   std::int_fast64_t jan1_time = jan1 - civil_second();
   int jan1_weekday = ToPosixWeekday(get_weekday(jan1));
 
-  Transition dst = {0, dst_ti, civil_second(), civil_second()};
-  Transition std = {0, std_ti, civil_second(), civil_second()};
-  for (const year_t limit = last_year_ + 400;; ++last_year_) {
+  for (const year_t limit = last_year_ + years;; ++last_year_) {
     auto dst_trans_off = TransOffset(leap_year, jan1_weekday, posix.dst_start);
     auto std_trans_off = TransOffset(leap_year, jan1_weekday, posix.dst_end);
-    dst.unix_time = jan1_time + dst_trans_off - posix.std_offset;
-    std.unix_time = jan1_time + std_trans_off - posix.dst_offset;
-    const auto* ta = dst.unix_time < std.unix_time ? &dst : &std;
-    const auto* tb = dst.unix_time < std.unix_time ? &std : &dst;
-    if (last_time < tb->unix_time) {
-      if (last_time < ta->unix_time) transitions_.push_back(*ta);
-      transitions_.push_back(*tb);
+    const std::int_fast64_t dst_time =
+        jan1_time + dst_trans_off - posix.std_offset;
+    const std::int_fast64_t std_time =
+        jan1_time + std_trans_off - posix.dst_offset;
+    const bool dst_first = dst_time < std_time;
+    const std::int_fast64_t ta_time = dst_first ? dst_time : std_time;
+    const std::int_fast64_t tb_time = dst_first ? std_time : dst_time;
+    if (last_time < tb_time) {
+      if (last_time < ta_time) {
+        trans_unix_time_.push_back(ta_time);
+        trans_type_index_.push_back(dst_first ? dst_ti : std_ti);
+      }
+      trans_unix_time_.push_back(tb_time);
+      trans_type_index_.push_back(dst_first ? std_ti : dst_ti);
     }
     if (last_year_ == limit) break;
     jan1_time += kSecsPerYear[leap_year];
@@ -403,13 +580,28 @@ bool TimeZoneInfo::ExtendTransitions() {
     leap_year = !leap_year && IsLeap(last_year_ + 1);
   }
 
+  future_posix_ = posix;
+  future_std_type_ = std_ti;
+  future_dst_type_ = dst_ti;
+  if (years != 400) {
+    lazy_years_ = 400 - years;
+    last_year_ += lazy_years_;
+  }
   return true;
 }
 
 bool TimeZoneInfo::Load(ZoneInfoSource* zip) {
-  // Read and validate the header.
+  // Read and validate the header, diverting to LoadCompiled() if the
+  // source holds a compiled record from a zone bundle instead.
   tzhead tzh;
-  if (zip->Read(&tzh, sizeof(tzh)) != sizeof(tzh))
+  if (zip->Read(&tzh.tzh_magic, sizeof(tzh.tzh_magic)) !=
+      sizeof(tzh.tzh_magic))
+    return false;
+  if (strncmp(tzh.tzh_magic, ZONE_RECORD_MAGIC, sizeof(tzh.tzh_magic)) == 0)
+    return LoadCompiled(zip);
+  const std::size_t rest = sizeof(tzh) - sizeof(tzh.tzh_magic);
+  if (zip->Read(reinterpret_cast<char*>(&tzh) + sizeof(tzh.tzh_magic), rest) !=
+      rest)
     return false;
   if (strncmp(tzh.tzh_magic, TZ_MAGIC, sizeof(tzh.tzh_magic)) != 0)
     return false;
@@ -446,31 +638,39 @@ bool TimeZoneInfo::Load(ZoneInfoSource* zip) {
   if (hdr.ttisutcnt != 0 && hdr.ttisutcnt != hdr.typecnt)
     return false;
 
-  // Read the data into a local buffer.
-  std::size_t len = hdr.DataLength(time_len);
-  std::vector<char> tbuf(len);
-  if (zip->Read(tbuf.data(), len) != len)
-    return false;
-  const char* bp = tbuf.data();
+  // Decode the data directly from the source when it is already resident
+  // in memory, or else read it into a local buffer.
+  const std::size_t len = hdr.DataLength(time_len);
+  std::vector<char> tbuf;
+  const char* bp = ReadInPlace(zip, len);
+  if (bp == nullptr) {
+    tbuf.resize(len);
+    if (zip->Read(tbuf.data(), len) != len)
+      return false;
+    bp = tbuf.data();
+  }
+  const char* const ep = bp + len;
 
   // Decode and validate the transitions.
-  transitions_.reserve(hdr.timecnt + 2);
-  transitions_.resize(hdr.timecnt);
+  trans_unix_time_.reserve(hdr.timecnt + 2);
+  trans_unix_time_.resize(hdr.timecnt);
   for (std::size_t i = 0; i != hdr.timecnt; ++i) {
-    transitions_[i].unix_time = (time_len == 4) ? Decode32(bp) : Decode64(bp);
+    trans_unix_time_[i] = (time_len == 4) ? Decode32(bp) : Decode64(bp);
     bp += time_len;
     if (i != 0) {
       // Check that the transitions are ordered by time (as zic guarantees).
-      if (!Transition::ByUnixTime()(transitions_[i - 1], transitions_[i]))
+      if (trans_unix_time_[i - 1] >= trans_unix_time_[i])
         return false;  // out of order
     }
   }
   bool seen_type_0 = false;
+  trans_type_index_.reserve(hdr.timecnt + 2);
+  trans_type_index_.resize(hdr.timecnt);
   for (std::size_t i = 0; i != hdr.timecnt; ++i) {
-    transitions_[i].type_index = Decode8(bp++);
-    if (transitions_[i].type_index >= hdr.typecnt)
+    trans_type_index_[i] = Decode8(bp++);
+    if (trans_type_index_[i] >= hdr.typecnt)
       return false;
-    if (transitions_[i].type_index == 0)
+    if (trans_type_index_[i] == 0)
       seen_type_0 = true;
   }
 
@@ -495,7 +695,7 @@ bool TimeZoneInfo::Load(ZoneInfoSource* zip) {
   if (seen_type_0 && hdr.timecnt != 0) {
     std::uint_fast8_t index = 0;
     if (transition_types_[0].is_dst) {
-      index = transitions_[0].type_index;
+      index = trans_type_index_[0];
       while (index != 0 && transition_types_[index].is_dst)
         --index;
     }
@@ -517,7 +717,8 @@ bool TimeZoneInfo::Load(ZoneInfoSource* zip) {
   bp += (time_len + 4) * hdr.leapcnt;  // leap-time + TAI-UTC
   bp += 1 * hdr.ttisstdcnt;            // UTC/local indicators
   bp += 1 * hdr.ttisutcnt;             // standard/wall indicators
-  assert(bp == tbuf.data() + tbuf.size());
+  assert(bp == ep);
+  static_cast<void>(ep);  // unused in NDEBUG builds
 
   future_spec_.clear();
   if (tzh.tzh_version[0] != '\0') {
@@ -550,22 +751,24 @@ bool TimeZoneInfo::Load(ZoneInfoSource* zip) {
   // zic.c:dontmerge) or to avoid bugs in old readers. For us, they just
   // get in the way when we do future_spec_ extension.
   while (hdr.timecnt > 1) {
-    if (!EquivTransitions(transitions_[hdr.timecnt - 1].type_index,
-                          transitions_[hdr.timecnt - 2].type_index)) {
+    if (!EquivTransitions(trans_type_index_[hdr.timecnt - 1],
+                          trans_type_index_[hdr.timecnt - 2])) {
       break;
     }
     hdr.timecnt -= 1;
   }
-  transitions_.resize(hdr.timecnt);
+  trans_unix_time_.resize(hdr.timecnt);
+  trans_type_index_.resize(hdr.timecnt);
 
   // Ensure that there is always a transition in the first half of the
   // time line (the second half is handled below) so that the signed
   // difference between a civil_second and the civil_second of its
   // previous transition is always representable, without overflow.
-  if (transitions_.empty() || transitions_.front().unix_time >= 0) {
-    Transition& tr(*transitions_.emplace(transitions_.begin()));
-    tr.unix_time = -(1LL << 59);  // -18267312070-10-26T17:01:52+00:00
-    tr.type_index = default_transition_type_;
+  if (trans_unix_time_.empty() || trans_unix_time_.front() >= 0) {
+    // -18267312070-10-26T17:01:52+00:00
+    trans_unix_time_.insert(trans_unix_time_.begin(), -(1LL << 59));
+    trans_type_index_.insert(trans_type_index_.begin(),
+                             default_transition_type_);
   }
 
   // Extend the transitions using the future specification.
@@ -575,27 +778,36 @@ bool TimeZoneInfo::Load(ZoneInfoSource* zip) {
   // time line (the first half is handled above) so that the signed
   // difference between a civil_second and the civil_second of its
   // previous transition is always representable, without overflow.
-  const Transition& last(transitions_.back());
-  if (last.unix_time < 0) {
-    const std::uint_fast8_t type_index = last.type_index;
-    Transition& tr(*transitions_.emplace(transitions_.end()));
-    tr.unix_time = 2147483647;  // 2038-01-19T03:14:07+00:00
-    tr.type_index = type_index;
+  if (trans_unix_time_.back() < 0) {
+    const std::uint_least8_t type_index = trans_type_index_.back();
+    trans_unix_time_.push_back(2147483647);  // 2038-01-19T03:14:07+00:00
+    trans_type_index_.push_back(type_index);
   }
 
+  return ComputeCivilTimes();
+}
+
+// Completes the loading of the transitions and transition_types_, which must
+// already be validated, by filling in their civil-time fields.
+bool TimeZoneInfo::ComputeCivilTimes() {
   // Compute the local civil time for each transition and the preceding
   // second. These will be used for reverse conversions in MakeTime().
+  const std::size_t timecnt = trans_unix_time_.size();
+  trans_civil_sec_.resize(timecnt);
+  trans_prev_civil_sec_.resize(timecnt);
   const TransitionType* ttp = &transition_types_[default_transition_type_];
-  for (std::size_t i = 0; i != transitions_.size(); ++i) {
-    Transition& tr(transitions_[i]);
-    tr.prev_civil_sec = LocalTime(tr.unix_time, *ttp).cs - 1;
-    ttp = &transition_types_[tr.type_index];
-    tr.civil_sec = LocalTime(tr.unix_time, *ttp).cs;
+  for (std::size_t i = 0; i != timecnt; ++i) {
+    const std::int_fast64_t unix_time = trans_unix_time_[i];
+    if (unix_time < kMinTransitionTime || unix_time > kMaxTransitionTime)
+      return false;  // keeps the civil keys well clear of overflow
+    trans_prev_civil_sec_[i] = unix_time + ttp->utc_offset - 1;
+    ttp = &transition_types_[trans_type_index_[i]];
+    trans_civil_sec_[i] = unix_time + ttp->utc_offset;
     if (i != 0) {
       // Check that the transitions are ordered by civil time. Essentially
       // this means that an offset change cannot cross another such change.
       // No one does this in practice, and we depend on it in MakeTime().
-      if (!Transition::ByCivilTime()(transitions_[i - 1], tr))
+      if (trans_civil_sec_[i - 1] >= trans_civil_sec_[i])
         return false;  // out of order
     }
   }
@@ -607,10 +819,148 @@ bool TimeZoneInfo::Load(ZoneInfoSource* zip) {
     tt.civil_min = LocalTime(seconds::min().count(), tt).cs;
   }
 
-  transitions_.shrink_to_fit();
+  trans_unix_time_.shrink_to_fit();
+  trans_type_index_.shrink_to_fit();
   return true;
 }
 
+void TimeZoneInfo::Compile(std::string* record) const {
+  // Any transitions that are extended lazily are generated here, so that
+  // the record always holds all 400 years of them.
+  std::vector<std::int_least64_t> unix_times(trans_unix_time_);
+  std::vector<std::uint_least8_t> type_indexes(trans_type_index_);
+  if (lazy_years_ != 0) {
+    for (year_t year = last_year_ - lazy_years_ + 1; year <= last_year_;
+         ++year) {
+      std::int_fast64_t times[2];
+      std::uint_fast8_t types[2];
+      RuleTransitions(year, times, types);
+      unix_times.insert(unix_times.end(), times, times + 2);
+      type_indexes.insert(type_indexes.end(), types, types + 2);
+    }
+  }
+
+  record->append(ZONE_RECORD_MAGIC, 4);
+  Encode32(static_cast<std::int_fast32_t>(unix_times.size()), record);
+  Encode32(static_cast<std::int_fast32_t>(transition_types_.size()), record);
+  Encode32(static_cast<std::int_fast32_t>(abbreviations_.size()), record);
+  Encode32(static_cast<std::int_fast32_t>(future_spec_.size()), record);
+  record->push_back(static_cast<char>(default_transition_type_));
+  record->push_back(extended_ ? 1 : 0);
+  Encode64(extended_ ? last_year_ : 0, record);
+  for (const std::int_least64_t unix_time : unix_times) {
+    Encode64(unix_time, record);
+  }
+  for (const std::uint_least8_t type_index : type_indexes) {
+    record->push_back(static_cast<char>(type_index));
+  }
+  for (const TransitionType& tt : transition_types_) {
+    Encode32(tt.utc_offset, record);
+    record->push_back(tt.is_dst ? 1 : 0);
+    record->push_back(static_cast<char>(tt.abbr_index));
+  }
+  record->append(abbreviations_);
+  record->append(future_spec_);
+}
+
+// Loads a compiled record (see zone_bundle.h), whose magic has already
+// been consumed. As the transitions were extended when the record was
+// compiled, all that remains is to validate them and compute civil times.
+bool TimeZoneInfo::LoadCompiled(ZoneInfoSource* zip) {
+  char hbuf[4 * 4 + 1 + 1 + 8];
+  if (zip->Read(hbuf, sizeof(hbuf)) != sizeof(hbuf))
+    return false;
+  const std::int_fast32_t timecnt = Decode32(hbuf + 0);
+  const std::int_fast32_t typecnt = Decode32(hbuf + 4);
+  const std::int_fast32_t charcnt = Decode32(hbuf + 8);
+  const std::int_fast32_t speclen = Decode32(hbuf + 12);
+  if (timecnt <= 0 || typecnt <= 0 || typecnt > 256 || charcnt <= 0 ||
+      speclen < 0)
+    return false;
+  default_transition_type_ = Decode8(hbuf + 16);
+  if (default_transition_type_ >= typecnt)
+    return false;
+  extended_ = (Decode8(hbuf + 17) != 0);
+  last_year_ = Decode64(hbuf + 18);
+
+  const auto ntimes = static_cast<std::size_t>(timecnt);
+  const auto ntypes = static_cast<std::size_t>(typecnt);
+  const auto nchars = static_cast<std::size_t>(charcnt);
+  const auto nspec = static_cast<std::size_t>(speclen);
+  const std::size_t len = ntimes * (8 + 1) + ntypes * (4 + 1 + 1) + nchars;
+  std::vector<char> tbuf;
+  const char* bp = ReadInPlace(zip, len);
+  if (bp == nullptr) {
+    tbuf.resize(len);
+    if (zip->Read(tbuf.data(), len) != len)
+      return false;
+    bp = tbuf.data();
+  }
+
+  trans_unix_time_.resize(ntimes);
+  for (std::size_t i = 0; i != ntimes; ++i) {
+    trans_unix_time_[i] = Decode64(bp);
+    bp += 8;
+    if (i != 0) {
+      if (trans_unix_time_[i - 1] >= trans_unix_time_[i])
+        return false;  // out of order
+    }
+  }
+  trans_type_index_.resize(ntimes);
+  for (std::size_t i = 0; i != ntimes; ++i) {
+    trans_type_index_[i] = Decode8(bp++);
+    if (trans_type_index_[i] >= ntypes)
+      return false;
+  }
+  transition_types_.resize(ntypes);
+  for (std::size_t i = 0; i != ntypes; ++i) {
+    transition_types_[i].utc_offset =
+        static_cast<std::int_least32_t>(Decode32(bp));
+    if (transition_types_[i].utc_offset >= kSecsPerDay ||
+        transition_types_[i].utc_offset <= -kSecsPerDay)
+      return false;
+    bp += 4;
+    transition_types_[i].is_dst = (Decode8(bp++) != 0);
+    transition_types_[i].abbr_index = Decode8(bp++);
+    if (transition_types_[i].abbr_index >= nchars)
+      return false;
+  }
+  abbreviations_.assign(bp, nchars);
+  if (abbreviations_.back() != '\0')
+    return false;
+
+  future_spec_.resize(nspec);
+  if (nspec != 0 && zip->Read(&future_spec_[0], nspec) != nspec)
+    return false;
+  if (version_.empty()) {
+    version_ = zip->Version();
+  }
+
+  // Recover the future rules, which are used after the final transition.
+  // The record holds all 400 years of extended transitions, so when
+  // extending lazily we also drop the final ones.
+  if (extended_) {
+    PosixTimeZone& posix(future_posix_);
+    if (!ParsePosixSpec(future_spec_, &posix)) return false;
+    if (!GetTransitionType(posix.std_offset, false, posix.std_abbr,
+                           &future_std_type_))
+      return false;
+    if (!GetTransitionType(posix.dst_offset, true, posix.dst_abbr,
+                           &future_dst_type_))
+      return false;
+    const year_t years = ExtensionYears();
+    if (years != 400) {
+      lazy_years_ = 400 - years;
+      const std::size_t nlazy = static_cast<std::size_t>(lazy_years_) * 2;
+      if (nlazy >= ntimes) return false;
+      trans_unix_time_.resize(ntimes - nlazy);
+      trans_type_index_.resize(ntimes - nlazy);
+    }
+  }
+
+  return ComputeCivilTimes();
+}
+
 namespace {
 
 using FilePtr = std::unique_ptr<FILE, int(*)(FILE*)>;
@@ -659,12 +1009,11 @@ class FileZoneInfoSource : public ZoneInfoSource {
   std::size_t len_;
 };
 
-std::unique_ptr<ZoneInfoSource> FileZoneInfoSource::Open(
-    const std::string& name) {
+// Maps a time-zone name to the path name of its zoneinfo file.
+std::string ZoneInfoPath(const std::string& name) {
   // Use of the "file:" prefix is intended for testing purposes only.
   const std::size_t pos = (name.compare(0, 5, "file:") == 0) ? 5 : 0;
 
-  // Map the time-zone name to a path name.
   std::string path;
   if (pos == name.size() || name[pos] != '/') {
     const char* tzdir = "/usr/share/zoneinfo";
@@ -682,13 +1031,206 @@ std::unique_ptr<ZoneInfoSource> FileZoneInfoSource::Open(
 #endif
   }
   path.append(name, pos, std::string::npos);
+  return path;
+}
 
+std::unique_ptr<ZoneInfoSource> FileZoneInfoSource::Open(
+    const std::string& name) {
   // Open the zoneinfo file.
-  auto fp = FOpen(path.c_str(), "rb");
+  auto fp = FOpen(ZoneInfoPath(name).c_str(), "rb");
   if (fp == nullptr) return nullptr;
   return std::unique_ptr<ZoneInfoSource>(new FileZoneInfoSource(std::move(fp)));
 }
 
+#if defined(CCTZ_HAVE_MMAP)
+// A ZoneInfoSource over the complete contents of a zoneinfo file. Large
+// files are memory mapped, while small ones (which includes all the usual
+// TZif files) are slurped with a single read(2), as that is cheaper than
+// the mmap(2)/munmap(2) pair plus the page fault.
+class MmapZoneInfoSource : public MemoryZoneInfoSource {
+ public:
+  static std::unique_ptr<ZoneInfoSource> Open(const std::string& name);
+
+  ~MmapZoneInfoSource() override {
+    if (map_ != nullptr) munmap(map_, map_len_);
+  }
+
+ private:
+  // Files at least this large are mapped rather than read.
+  static const std::size_t kMinMappedSize = 64 * 1024;
+
+  MmapZoneInfoSource(std::unique_ptr<char[]> buf, std::size_t len)
+      : MemoryZoneInfoSource(buf.get(), len),
+        buf_(std::move(buf)),
+        map_(nullptr),
+        map_len_(0) {}
+  MmapZoneInfoSource(void* map, std::size_t len)
+      : MemoryZoneInfoSource(static_cast<const char*>(map), len),
+        map_(map),
+        map_len_(len) {}
+
+  std::unique_ptr<char[]> buf_;
+  void* const map_;
+  const std::size_t map_len_;
+};
+
+// Returns the size of the regular file open on fd, or zero.
+std::size_t RegularFileSize(int fd) {
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0) return 0;
+  return static_cast<std::size_t>(st.st_size);
+}
+
+// Returns a read-only mapping of the first len bytes of the file open on
+// fd, or nullptr. The mapping outlives fd.
+void* MapFile(int fd, std::size_t len) {
+  void* map = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+  return (map != MAP_FAILED) ? map : nullptr;
+}
+
+std::unique_ptr<ZoneInfoSource> MmapZoneInfoSource::Open(
+    const std::string& name) {
+  int fd = open(ZoneInfoPath(name).c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd == -1) return nullptr;
+  std::unique_ptr<ZoneInfoSource> zip;
+  if (const std::size_t len = RegularFileSize(fd)) {
+    if (len >= kMinMappedSize) {
+      if (void* map = MapFile(fd, len)) {
+        zip.reset(new MmapZoneInfoSource(map, len));
+      }
+    } else {
+      std::unique_ptr<char[]> buf(new char[len]);
+      std::size_t nread = 0;
+      while (nread != len) {
+        ssize_t n = read(fd, buf.get() + nread, len - nread);
+        if (n <= 0) break;
+        nread += static_cast<std::size_t>(n);
+      }
+      if (nread == len) zip.reset(new MmapZoneInfoSource(std::move(buf), len));
+    }
+  }
+  close(fd);
+  return zip;
+}
+
+// The zone bundle (see zone_bundle.h) named by ${CCTZ_ZONE_BUNDLE}, which
+// is mapped upon first use, and remains so for the life of the process.
+class ZoneBundle {
+ public:
+  // Returns the bundle, or nullptr if there is no (valid) bundle.
+  static const ZoneBundle* Get() {
+    static const ZoneBundle* bundle = Open();
+    return bundle;
+  }
+
+  // Finds the compiled zoneinfo for the named zone.
+  bool Find(const std::string& name, const char** data,
+            std::size_t* len) const;
+
+  const std::string& version() const { return version_; }
+
+ private:
+  ZoneBundle(const char* base, std::size_t len) : base_(base), len_(len) {}
+
+  static const ZoneBundle* Open();
+
+  const char* const base_;
+  const std::size_t len_;
+  const zone_bundle_entry* index_;
+  std::size_t zonecnt_;
+  std::size_t data_offset_;
+  std::string version_;
+};
+
+const ZoneBundle* ZoneBundle::Open() {
+  const char* path = std::getenv("CCTZ_ZONE_BUNDLE");
+  if (path == nullptr || *path == '\0') return nullptr;
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd == -1) return nullptr;
+  const std::size_t len = RegularFileSize(fd);
+  void* map = (len != 0) ? MapFile(fd, len) : nullptr;
+  close(fd);
+  if (map == nullptr) return nullptr;
+
+  // Validate the header and the extent of the index.
+  std::unique_ptr<ZoneBundle> bundle(
+      new ZoneBundle(static_cast<const char*>(map), len));
+  const zone_bundle_header* hdr =
+      reinterpret_cast<const zone_bundle_header*>(bundle->base_);
+  if (len >= sizeof(*hdr) &&
+      memcmp(hdr->magic, ZONE_BUNDLE_MAGIC, sizeof(hdr->magic)) == 0) {
+    const std::int_fast32_t zonecnt = Decode32(hdr->zonecnt);
+    const std::int_fast32_t index_offset = Decode32(hdr->index_offset);
+    const std::int_fast32_t data_offset = Decode32(hdr->data_offset);
+    if (zonecnt >= 0 && index_offset >= 0 && data_offset >= 0) {
+      bundle->zonecnt_ = static_cast<std::size_t>(zonecnt);
+      bundle->data_offset_ = static_cast<std::size_t>(data_offset);
+      const auto index_end = static_cast<std::size_t>(index_offset) +
+                             bundle->zonecnt_ * sizeof(zone_bundle_entry);
+      if (index_end <= bundle->data_offset_ && bundle->data_offset_ <= len) {
+        bundle->index_ = reinterpret_cast<const zone_bundle_entry*>(
+            bundle->base_ + index_offset);
+        bundle->version_.assign(
+            hdr->version, strnlen(hdr->version, sizeof(hdr->version)));
+        return bundle.release();
+      }
+    }
+  }
+  munmap(map, len);
+  return nullptr;
+}
+
+bool ZoneBundle::Find(const std::string& name, const char** data,
+                      std::size_t* len) const {
+  const std::size_t kNameSize = sizeof(index_->name);
+  if (name.size() >= kNameSize) return false;
+  const char* key = name.c_str();
+  const zone_bundle_entry* const end = index_ + zonecnt_;
+  const zone_bundle_entry* entry = std::lower_bound(
+      index_, end, key, [kNameSize](const zone_bundle_entry& e, const char* k) {
+        return strncmp(e.name, k, kNameSize) < 0;
+      });
+  if (entry == end || strncmp(entry->name, key, kNameSize) != 0) return false;
+  const std::int_fast32_t offset = Decode32(entry->offset);
+  const std::int_fast32_t length = Decode32(entry->length);
+  if (offset < 0 || length < 0) return false;
+  const std::size_t start = data_offset_ + static_cast<std::size_t>(offset);
+  if (start > len_ || static_cast<std::size_t>(length) > len_ - start)
+    return false;
+  *data = base_ + start;
+  *len = static_cast<std::size_t>(length);
+  return true;
+}
+
+// A ZoneInfoSource over one zone from the ZoneBundle.
+class BundleZoneInfoSource : public MemoryZoneInfoSource {
+ public:
+  static std::unique_ptr<ZoneInfoSource> Open(const std::string& name);
+  std::string Version() const override { return version_; }
+
+ private:
+  BundleZoneInfoSource(const char* data, std::size_t len, std::string version)
+      : MemoryZoneInfoSource(data, len), version_(std::move(version)) {}
+  std::string version_;
+};
+
+std::unique_ptr<ZoneInfoSource> BundleZoneInfoSource::Open(
+    const std::string& name) {
+  const ZoneBundle* bundle = ZoneBundle::Get();
+  if (bundle == nullptr) return nullptr;
+
+  // Use of the "file:" prefix is intended for testing purposes only.
+  const std::size_t pos = (name.compare(0, 5, "file:") == 0) ? 5 : 0;
+  if (pos != name.size() && name[pos] == '/') return nullptr;  // absolute
+
+  const char* data = nullptr;
+  std::size_t len = 0;
+  if (!bundle->Find(name.substr(pos), &data, &len)) return nullptr;
+  return std::unique_ptr<ZoneInfoSource>(
+      new BundleZoneInfoSource(data, len, bundle->version()));
+}
+#endif  // CCTZ_HAVE_MMAP
+
 class AndroidZoneInfoSource : public FileZoneInfoSource {
  public:
   static std::unique_ptr<ZoneInfoSource> Open(const std::string& name);
@@ -812,7 +1354,9 @@ bool TimeZoneInfo::Load(const std::string& name) {
   // We can ensure that the loading of UTC or any other fixed-offset
   // zone never fails because the simple, fixed-offset state can be
   // internally generated. Note that this depends on our choice to not
-  // accept leap-second encoded ("right") zoneinfo.
+  // accept leap-second encoded ("right") zoneinfo. (TimeZoneIf::Load()
+  // uses a TimeZoneFixed for these instead, so this is only for direct
+  // users, like zone_bundle_tool.)
   auto offset = seconds::zero();
   if (FixedOffsetFromName(name, &offset)) {
     return ResetToBuiltinUTC(offset);
@@ -821,6 +1365,10 @@ bool TimeZoneInfo::Load(const std::string& name) {
   // Find and use a ZoneInfoSource to load the named zone.
   auto zip = cctz_extension::zone_info_source_factory(
       name, [](const std::string& n) -> std::unique_ptr<ZoneInfoSource> {
+#if defined(CCTZ_HAVE_MMAP)
+        if (auto z = BundleZoneInfoSource::Open(n)) return z;
+        if (auto z = MmapZoneInfoSource::Open(n)) return z;
+#endif
         if (auto z = FileZoneInfoSource::Open(n)) return z;
         if (auto z = AndroidZoneInfoSource::Open(n)) return z;
         if (auto z = FuchsiaZoneInfoSource::Open(n)) return z;
@@ -840,148 +1388,519 @@ time_zone::absolute_lookup TimeZoneInfo::LocalTime(
 }
 
 // BreakTime() translation for a particular transition.
-time_zone::absolute_lookup TimeZoneInfo::LocalTime(
-    std::int_fast64_t unix_time, const Transition& tr) const {
-  const TransitionType& tt = transition_types_[tr.type_index];
-  // Note: (unix_time - tr.unix_time) will never overflow as we
+time_zone::absolute_lookup TimeZoneInfo::LocalTime(std::int_fast64_t unix_time,
+                                                   std::size_t tr) const {
+  const TransitionType& tt = transition_types_[trans_type_index_[tr]];
+  // Note: (unix_time - trans_unix_time_[tr]) will never overflow as we
   // have ensured that there is always a "nearby" transition.
-  return {tr.civil_sec + (unix_time - tr.unix_time),  // TODO: Optimize.
-          tt.utc_offset, tt.is_dst, &abbreviations_[tt.abbr_index]};
+  const civil_second civil_sec = civil_second() + trans_civil_sec_[tr];
+  return {civil_sec + (unix_time - trans_unix_time_[tr]), tt.utc_offset,
+          tt.is_dst, &abbreviations_[tt.abbr_index]};
 }
 
-// MakeTime() translation with a conversion-preserving +N * 400-year shift.
-time_zone::civil_lookup TimeZoneInfo::TimeLocal(const civil_second& cs,
-                                                year_t c4_shift) const {
-  assert(last_year_ - 400 < cs.year() && cs.year() <= last_year_);
-  time_zone::civil_lookup cl = MakeTime(cs);
-  if (c4_shift > seconds::max().count() / kSecsPer400Years) {
-    cl.pre = cl.trans = cl.post = time_point<seconds>::max();
-  } else {
-    const auto offset = seconds(c4_shift * kSecsPer400Years);
-    const auto limit = time_point<seconds>::max() - offset;
-    for (auto* tp : {&cl.pre, &cl.trans, &cl.post}) {
-      if (*tp > limit) {
-        *tp = time_point<seconds>::max();
-      } else {
-        *tp += offset;
-      }
-    }
-  }
-  return cl;
+TimeZoneInfo::HintStats TimeZoneInfo::ThreadHintStatsTestOnly() {
+  return thread_hint_stats;
 }
 
 time_zone::absolute_lookup TimeZoneInfo::BreakTime(
     const time_point<seconds>& tp) const {
   std::int_fast64_t unix_time = ToUnixSeconds(tp);
-  const std::size_t timecnt = transitions_.size();
+  const std::size_t timecnt = trans_unix_time_.size();
   assert(timecnt != 0);  // We always add a transition.
 
-  if (unix_time < transitions_[0].unix_time) {
+  if (unix_time < trans_unix_time_[0]) {
     return LocalTime(unix_time, transition_types_[default_transition_type_]);
   }
-  if (unix_time >= transitions_[timecnt - 1].unix_time) {
+  if (unix_time >= trans_unix_time_[timecnt - 1]) {
     // After the last transition. If we extended the transitions using
-    // future_spec_, shift back to a supported year using the 400-year
-    // cycle of calendaric equivalence and then compensate accordingly.
-    if (extended_) {
-      const std::int_fast64_t diff =
-          unix_time - transitions_[timecnt - 1].unix_time;
-      const year_t shift = diff / kSecsPer400Years + 1;
-      const auto d = seconds(shift * kSecsPer400Years);
-      time_zone::absolute_lookup al = BreakTime(tp - d);
-      al.cs = YearShift(al.cs, shift * 400);
-      return al;
-    }
-    return LocalTime(unix_time, transitions_[timecnt - 1]);
+    // future_spec_, evaluate its rules directly.
+    if (extended_) return RuleLocalTime(unix_time);
+    return LocalTime(unix_time, timecnt - 1);
   }
 
-  const std::size_t hint = local_time_hint_.load(std::memory_order_relaxed);
+  LookupHints& hints = ThreadHints(this);
+  const std::size_t hint = hints.local_time;
+  ++thread_hint_stats.checks;
   if (0 < hint && hint < timecnt) {
-    if (transitions_[hint - 1].unix_time <= unix_time) {
-      if (unix_time < transitions_[hint].unix_time) {
-        return LocalTime(unix_time, transitions_[hint - 1]);
+    if (trans_unix_time_[hint - 1] <= unix_time) {
+      if (unix_time < trans_unix_time_[hint]) {
+        ++thread_hint_stats.hits;
+        return LocalTime(unix_time, hint - 1);
       }
     }
   }
 
-  const Transition target = {unix_time, 0, civil_second(), civil_second()};
-  const Transition* begin = &transitions_[0];
-  const Transition* tr = std::upper_bound(begin, begin + timecnt, target,
-                                          Transition::ByUnixTime());
-  local_time_hint_.store(static_cast<std::size_t>(tr - begin),
-                         std::memory_order_relaxed);
-  return LocalTime(unix_time, *--tr);
+  const std::size_t tr = UpperBound(&trans_unix_time_[0], timecnt, unix_time);
+  hints.local_time = tr;
+  return LocalTime(unix_time, tr - 1);
+}
+
+void TimeZoneInfo::BreakTimes(const time_point<seconds>* tps, std::size_t n,
+                              time_zone::absolute_lookup* als) const {
+  const std::size_t timecnt = trans_unix_time_.size();
+  assert(timecnt != 0);  // We always add a transition.
+  const std::int_least64_t* const begin = &trans_unix_time_[0];
+  const std::int_least64_t* const end = begin + timecnt;
+
+  // We maintain tr such that [tr[-1], tr[0]) is the interval containing
+  // the previous element. Consecutive elements usually fall in the same,
+  // or a nearby, interval, so rather than performing a full binary search
+  // we gallop from tr in the appropriate direction.
+  LookupHints& hints = ThreadHints(this);
+  std::size_t hint = hints.local_time;
+  if (hint == 0 || hint >= timecnt) hint = 1;
+  const std::int_least64_t* tr = begin + hint;
+
+  for (std::size_t i = 0; i != n; ++i) {
+    const std::int_fast64_t unix_time = ToUnixSeconds(tps[i]);
+    if (unix_time < begin[0] || unix_time >= end[-1]) {
+      // Before the first or after the last transition.
+      als[i] = BreakTime(tps[i]);
+      continue;
+    }
+    // Now begin[0] <= unix_time < end[-1], so the desired tr is
+    // somewhere in (begin, end).
+    tr = UpperBoundFrom(begin, end, tr, unix_time);
+    als[i] = LocalTime(unix_time, static_cast<std::size_t>(tr - begin) - 1);
+  }
+
+  hints.local_time = static_cast<std::size_t>(tr - begin);
+}
+
+time_zone::absolute_lookup TimeZoneInfo::BreakTimeSpan(
+    const time_point<seconds>& tp, std::size_t* hint,
+    time_point<seconds>* first, time_point<seconds>* last) const {
+  const std::size_t timecnt = trans_unix_time_.size();
+  assert(timecnt != 0);  // We always add a transition.
+  const std::int_least64_t* const begin = &trans_unix_time_[0];
+  const std::int_least64_t* const end = begin + timecnt;
+
+  const std::int_fast64_t unix_time = ToUnixSeconds(tp);
+  if (unix_time < begin[0]) {
+    *first = time_point<seconds>::min();
+    *last = FromUnixSeconds(begin[0] - 1);
+    return LocalTime(unix_time, transition_types_[default_transition_type_]);
+  }
+  if (unix_time >= end[-1]) {
+    if (extended_) {
+      // The rule transitions are not stored, so the span is just tp.
+      *first = *last = tp;
+      return RuleLocalTime(unix_time);
+    }
+    *first = FromUnixSeconds(end[-1]);
+    *last = time_point<seconds>::max();
+    return LocalTime(unix_time, timecnt - 1);
+  }
+
+  // As in BreakTimes(), we gallop from the previous position, which, for
+  // an increasing sequence of times, is usually just one step.
+  const std::size_t from = (*hint == 0 || *hint >= timecnt) ? 1 : *hint;
+  const std::size_t tr =
+      static_cast<std::size_t>(
+          UpperBoundFrom(begin, end, begin + from, unix_time) - begin);
+  *hint = tr;
+  *first = FromUnixSeconds(begin[tr - 1]);
+  *last = FromUnixSeconds(begin[tr] - 1);
+  return LocalTime(unix_time, tr - 1);
 }
 
 time_zone::civil_lookup TimeZoneInfo::MakeTime(const civil_second& cs) const {
-  const std::size_t timecnt = transitions_.size();
+  const std::size_t timecnt = trans_civil_sec_.size();
   assert(timecnt != 0);  // We always add a transition.
 
   // Find the first transition after our target civil time.
-  const Transition* tr = nullptr;
-  const Transition* begin = &transitions_[0];
-  const Transition* end = begin + timecnt;
-  if (cs < begin->civil_sec) {
-    tr = begin;
-  } else if (cs >= transitions_[timecnt - 1].civil_sec) {
-    tr = end;
+  if (cs.year() < kMinTransitionYear) return MakeTimeAt(cs, 0, 0);
+  if (cs.year() > kMaxTransitionYear) return MakeTimeAt(cs, 0, timecnt);
+  const std::int_fast64_t key = cs - civil_second();
+  const std::int_least64_t* begin = &trans_civil_sec_[0];
+  const std::int_least64_t* end = begin + timecnt;
+  std::size_t tr = 0;
+  if (key < begin[0]) {
+    tr = 0;
+  } else if (key >= end[-1]) {
+    tr = timecnt;
   } else {
-    const std::size_t hint = time_local_hint_.load(std::memory_order_relaxed);
-    if (0 < hint && hint < timecnt) {
-      if (transitions_[hint - 1].civil_sec <= cs) {
-        if (cs < transitions_[hint].civil_sec) {
-          tr = begin + hint;
-        }
-      }
+    LookupHints& hints = ThreadHints(this);
+    const std::size_t hint = hints.time_local;
+    ++thread_hint_stats.checks;
+    if (0 < hint && hint < timecnt && begin[hint - 1] <= key &&
+        key < begin[hint]) {
+      ++thread_hint_stats.hits;
+      tr = hint;
+    } else {
+      tr = UpperBound(begin, timecnt, key);
+      hints.time_local = tr;
+    }
+  }
+
+  return MakeTimeAt(cs, key, tr);
+}
+
+void TimeZoneInfo::MakeTimes(const civil_second* cs, std::size_t n,
+                             time_zone::civil_lookup* cls) const {
+  const std::size_t timecnt = trans_civil_sec_.size();
+  assert(timecnt != 0);  // We always add a transition.
+  const std::int_least64_t* const begin = &trans_civil_sec_[0];
+  const std::int_least64_t* const end = begin + timecnt;
+
+  // As in BreakTimes(), tr follows the previous element, here using
+  // the civil-time ordering of the transitions.
+  LookupHints& hints = ThreadHints(this);
+  std::size_t hint = hints.time_local;
+  if (hint == 0 || hint >= timecnt) hint = 1;
+  const std::int_least64_t* tr = begin + hint;
+
+  for (std::size_t i = 0; i != n; ++i) {
+    if (cs[i].year() < kMinTransitionYear ||
+        cs[i].year() > kMaxTransitionYear) {
+      cls[i] = MakeTime(cs[i]);
+      continue;
     }
-    if (tr == nullptr) {
-      const Transition target = {0, 0, cs, civil_second()};
-      tr = std::upper_bound(begin, end, target, Transition::ByCivilTime());
-      time_local_hint_.store(static_cast<std::size_t>(tr - begin),
-                             std::memory_order_relaxed);
+    const std::int_fast64_t key = cs[i] - civil_second();
+    if (key < begin[0]) {
+      cls[i] = MakeTimeAt(cs[i], key, 0);
+    } else if (key >= end[-1]) {
+      cls[i] = MakeTimeAt(cs[i], key, timecnt);
+    } else {
+      tr = UpperBoundFrom(begin, end, tr, key);
+      cls[i] = MakeTimeAt(cs[i], key, static_cast<std::size_t>(tr - begin));
     }
   }
 
-  if (tr == begin) {
-    if (tr->prev_civil_sec >= cs) {
+  hints.time_local = static_cast<std::size_t>(tr - begin);
+}
+
+// The remainder of MakeTime(), given the index of the first transition
+// after the target civil time (which may be the first or past-the-end
+// transition), and the target as seconds since civil_second(), which
+// need only be valid when the target is within the transition years.
+time_zone::civil_lookup TimeZoneInfo::MakeTimeAt(const civil_second& cs,
+                                                 std::int_fast64_t key,
+                                                 std::size_t tr) const {
+  const std::size_t timecnt = trans_civil_sec_.size();
+  if (tr == 0) {
+    if (cs.year() < kMinTransitionYear || key <= trans_prev_civil_sec_[tr]) {
       // Before first transition, so use the default offset.
       const TransitionType& tt(transition_types_[default_transition_type_]);
-      if (cs < tt.civil_min) return MakeUnique(time_point<seconds>::min());
-      return MakeUnique(cs - (civil_second() + tt.utc_offset));
+      return MakeUnique(TimeAt(cs, tt));
     }
-    // tr->prev_civil_sec < cs < tr->civil_sec
-    return MakeSkipped(*tr, cs);
+    // trans_prev_civil_sec_[tr] < cs < trans_civil_sec_[tr]
+    return MakeSkipped(trans_unix_time_[tr], trans_civil_sec_[tr],
+                       trans_prev_civil_sec_[tr], key);
   }
 
-  if (tr == end) {
-    if (cs > (--tr)->prev_civil_sec) {
+  if (tr == timecnt) {
+    --tr;
+    if (cs.year() > kMaxTransitionYear || key > trans_prev_civil_sec_[tr]) {
       // After the last transition. If we extended the transitions using
-      // future_spec_, shift back to a supported year using the 400-year
-      // cycle of calendaric equivalence and then compensate accordingly.
-      if (extended_ && cs.year() > last_year_) {
-        const year_t shift = (cs.year() - last_year_ - 1) / 400 + 1;
-        return TimeLocal(YearShift(cs, shift * -400), shift);
-      }
-      const TransitionType& tt(transition_types_[tr->type_index]);
-      if (cs > tt.civil_max) return MakeUnique(time_point<seconds>::max());
-      return MakeUnique(tr->unix_time + (cs - tr->civil_sec));
+      // future_spec_, evaluate its rules directly.
+      if (extended_) return RuleTimeLocal(cs);
+      const TransitionType& tt(transition_types_[trans_type_index_[tr]]);
+      return MakeUnique(TimeAt(cs, tt));
     }
-    // tr->civil_sec <= cs <= tr->prev_civil_sec
-    return MakeRepeated(*tr, cs);
+    // trans_civil_sec_[tr] <= cs <= trans_prev_civil_sec_[tr]
+    return MakeRepeated(trans_unix_time_[tr], trans_civil_sec_[tr],
+                        trans_prev_civil_sec_[tr], key);
   }
 
-  if (tr->prev_civil_sec < cs) {
-    // tr->prev_civil_sec < cs < tr->civil_sec
-    return MakeSkipped(*tr, cs);
+  if (trans_prev_civil_sec_[tr] < key) {
+    // trans_prev_civil_sec_[tr] < cs < trans_civil_sec_[tr]
+    return MakeSkipped(trans_unix_time_[tr], trans_civil_sec_[tr],
+                       trans_prev_civil_sec_[tr], key);
   }
 
-  if (cs <= (--tr)->prev_civil_sec) {
-    // tr->civil_sec <= cs <= tr->prev_civil_sec
-    return MakeRepeated(*tr, cs);
+  if (key <= trans_prev_civil_sec_[--tr]) {
+    // trans_civil_sec_[tr] <= cs <= trans_prev_civil_sec_[tr]
+    return MakeRepeated(trans_unix_time_[tr], trans_civil_sec_[tr],
+                        trans_prev_civil_sec_[tr], key);
   }
 
   // In between transitions.
-  return MakeUnique(tr->unix_time + (cs - tr->civil_sec));
+  return MakeUnique(trans_unix_time_[tr] + (key - trans_civil_sec_[tr]));
+}
+
+// Computes the two transitions in the given year under the future rules,
+// in time order, as offsets from the start of the year in UTC. These only
+// depend upon the position of the year within the 400-year cycle.
+void TimeZoneInfo::RuleOffsets(year_t year, std::int_fast64_t* offsets,
+                               std::uint_fast8_t* type_indexes) const {
+  const PosixTimeZone& posix(future_posix_);
+  const bool leap_year = IsLeap(year);
+  const std::int_fast64_t jan1_day = DaysFromCivil(CycleYear(year), 1, 1);
+  const int jan1_weekday = static_cast<int>((jan1_day + 4) % 7);  // Thu 1970
+  const std::int_fast64_t dst_offset =
+      TransOffset(leap_year, jan1_weekday, posix.dst_start) - posix.std_offset;
+  const std::int_fast64_t std_offset =
+      TransOffset(leap_year, jan1_weekday, posix.dst_end) - posix.dst_offset;
+  const bool dst_first = dst_offset < std_offset;
+  offsets[0] = dst_first ? dst_offset : std_offset;
+  offsets[1] = dst_first ? std_offset : dst_offset;
+  type_indexes[0] = dst_first ? future_dst_type_ : future_std_type_;
+  type_indexes[1] = dst_first ? future_std_type_ : future_dst_type_;
+}
+
+// As RuleOffsets(), but as times, as ExtendTransitions() would generate.
+void TimeZoneInfo::RuleTransitions(year_t year, std::int_fast64_t* unix_times,
+                                   std::uint_fast8_t* type_indexes) const {
+  RuleOffsets(year, unix_times, type_indexes);
+  const std::int_fast64_t jan1_time = civil_second(year) - civil_second();
+  unix_times[0] += jan1_time;
+  unix_times[1] += jan1_time;
+}
+
+// BreakTime() for an instant after the generated transitions of an
+// extended zone. We find the transition type in effect directly from
+// the position of the instant within its year, with no search, and no
+// shift to a cycle-equivalent year, however far in the future it is.
+time_zone::absolute_lookup TimeZoneInfo::RuleLocalTime(
+    std::int_fast64_t unix_time) const {
+  const civil_second cs = UnixToCivil(unix_time, 0);
+  const year_t year = cs.year();
+  const std::int_fast64_t secs = SecondsInYear(cs);
+  std::int_fast64_t offsets[2];
+  std::uint_fast8_t types[2];
+  RuleOffsets(year, offsets, types);
+  std::uint_fast8_t type_index = types[1];
+  if (secs < offsets[0]) {
+    // The previous year's final transition (usually) prevails.
+    std::int_fast64_t prev_offsets[2];
+    std::uint_fast8_t prev_types[2];
+    RuleOffsets(year - 1, prev_offsets, prev_types);
+    const std::int_fast64_t prev_len = kSecsPerYear[IsLeap(year - 1)];
+    type_index = (prev_offsets[1] - prev_len <= secs) ? prev_types[1]
+                                                      : prev_types[0];
+  } else if (secs < offsets[1]) {
+    type_index = types[0];
+  } else {
+    // A transition is never more than a week (plus its UTC offset) before
+    // the start of its year, so we need only consider the next year close
+    // to its start.
+    const std::int_fast64_t len = kSecsPerYear[IsLeap(year)];
+    if (secs >= len - 8 * kSecsPerDay) {
+      std::int_fast64_t next_offsets[2];
+      std::uint_fast8_t next_types[2];
+      RuleOffsets(year + 1, next_offsets, next_types);
+      if (len + next_offsets[0] <= secs) type_index = next_types[0];
+    }
+  }
+  const TransitionType& tt = transition_types_[type_index];
+  return {UnixToCivil(unix_time, tt.utc_offset), tt.utc_offset, tt.is_dst,
+          &abbreviations_[tt.abbr_index]};
+}
+
+// MakeTime() for a civil time after the generated transitions of an
+// extended zone, which, like RuleLocalTime(), neither searches nor shifts.
+time_zone::civil_lookup TimeZoneInfo::RuleTimeLocal(
+    const civil_second& cs) const {
+  const year_t year = cs.year();
+  const std::int_fast64_t secs = SecondsInYear(cs);
+
+  // The rule transitions of the surrounding years, as offsets from the
+  // start of the year. As the years only matter within the 400-year cycle,
+  // we use an equivalent year that we can step without fear of overflow.
+  // POSIX rule times are within 167 hours of midnight, and UTC offsets
+  // within 25 hours, so the neighboring years can only matter within nine
+  // days of the boundary. Otherwise we give their transitions sentinel
+  // offsets, and the types that the rules alternate between anyway.
+  const year_t cycle_year = CycleYear(year);
+  std::int_fast64_t offsets[3 * 2];
+  std::uint_fast8_t types[3 * 2];
+  RuleOffsets(cycle_year, &offsets[2], &types[2]);
+  const std::int_fast64_t len = kSecsPerYear[IsLeap(cycle_year)];
+  if (secs < 9 * kSecsPerDay) {
+    RuleOffsets(cycle_year - 1, &offsets[0], &types[0]);
+    const std::int_fast64_t prev_len = kSecsPerYear[IsLeap(cycle_year - 1)];
+    offsets[0] -= prev_len;
+    offsets[1] -= prev_len;
+  } else {
+    offsets[0] = offsets[1] = -len;
+    types[0] = types[2];
+    types[1] = types[3];
+  }
+  if (secs >= len - 9 * kSecsPerDay) {
+    RuleOffsets(cycle_year + 1, &offsets[4], &types[4]);
+    offsets[4] += len;
+    offsets[5] += len;
+  } else {
+    offsets[4] = offsets[5] = 2 * len;
+    types[4] = types[2];
+    types[5] = types[3];
+  }
+
+  // The local civil time of each transition, and of the second before
+  // it, as offsets from the start of the year. The rules alternate
+  // between standard and daylight time, so the first one follows the
+  // type that the second one transitions to.
+  std::int_fast64_t civil_secs[3 * 2];
+  std::int_fast64_t prev_civil_secs[3 * 2];
+  for (std::size_t i = 0; i != 3 * 2; ++i) {
+    const std::uint_fast8_t prev_type = types[i == 0 ? 1 : i - 1];
+    civil_secs[i] = offsets[i] + transition_types_[types[i]].utc_offset;
+    prev_civil_secs[i] =
+        offsets[i] + transition_types_[prev_type].utc_offset - 1;
+  }
+
+  // Find the first transition after the target civil time, and then
+  // proceed as in MakeTimeAt().
+  std::size_t tr = 1;
+  while (tr != 3 * 2 - 1 && civil_secs[tr] <= secs) ++tr;
+  std::size_t at = tr;
+  time_zone::civil_lookup cl;
+  if (prev_civil_secs[tr] < secs) {
+    // prev_civil_secs[tr] < cs < civil_secs[tr]
+    cl.kind = time_zone::civil_lookup::SKIPPED;
+  } else if (secs <= prev_civil_secs[--at]) {
+    // civil_secs[at] <= cs <= prev_civil_secs[at]
+    cl.kind = time_zone::civil_lookup::REPEATED;
+  } else {
+    // In between transitions.
+    return MakeUnique(TimeAt(cs, transition_types_[types[at]]));
+  }
+  const TransitionType& tt(transition_types_[types[at]]);
+  const TransitionType& prev_tt(transition_types_[types[at == 0 ? 1 : at - 1]]);
+  cl.pre = TimeAt(cs, prev_tt);
+  cl.trans = TimeAt(civil_second(year) + civil_secs[at], tt);
+  cl.post = TimeAt(cs, tt);
+  return cl;
+}
+
+// Reports a rule transition of a lazily-extended zone. The rules alternate
+// between standard and daylight time, so the previous type is the other.
+void TimeZoneInfo::RuleTransition(std::int_fast64_t unix_time,
+                                  std::uint_fast8_t type_index,
+                                  time_zone::civil_transition* trans) const {
+  const std::uint_fast8_t prev_type_index =
+      (type_index == future_dst_type_) ? future_std_type_ : future_dst_type_;
+  trans->from = civil_second() + unix_time +
+                transition_types_[prev_type_index].utc_offset;
+  trans->to =
+      civil_second() + unix_time + transition_types_[type_index].utc_offset;
+}
+
+// NextTransition() for an instant at or after the final generated
+// transition of a lazily-extended zone.
+bool TimeZoneInfo::NextRuleTransition(
+    std::int_fast64_t unix_time, time_zone::civil_transition* trans) const {
+  const std::int_fast64_t last_time = trans_unix_time_.back();
+  const year_t year = (civil_second() + unix_time).year();
+  for (year_t y = year - 1; y <= year + 1 && y <= last_year_; ++y) {
+    std::int_fast64_t times[2];
+    std::uint_fast8_t types[2];
+    RuleTransitions(y, times, types);
+    for (int i = 0; i != 2; ++i) {
+      if (times[i] > last_time && times[i] > unix_time) {
+        RuleTransition(times[i], types[i], trans);
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+// PrevTransition() for a lazily-extended zone, returning false when the
+// transition before unix_time is one of the generated transitions.
+bool TimeZoneInfo::PrevRuleTransition(
+    std::int_fast64_t unix_time, time_zone::civil_transition* trans) const {
+  const std::int_fast64_t last_time = trans_unix_time_.back();
+  if (unix_time <= last_time) return false;
+  const year_t year =
+      std::min((civil_second() + unix_time).year() + 1, last_year_);
+  for (year_t y = year; y >= year - 2; --y) {
+    std::int_fast64_t times[2];
+    std::uint_fast8_t types[2];
+    RuleTransitions(y, times, types);
+    for (int i = 2; i-- != 0;) {
+      if (times[i] <= last_time) return false;
+      if (times[i] < unix_time) {
+        RuleTransition(times[i], types[i], trans);
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+// The schedule comes straight from the transition arrays and, beyond them,
+// from the transitions of the future rules, generated year by year. So,
+// unlike enumeration by NextTransition(), it does not stop at last_year_,
+// but it does stop after kMaxScheduleYear (see time_zone::schedule()), so
+// that a schedule to, say, time_point<seconds>::max() is bounded.
+void TimeZoneInfo::Schedule(const time_point<seconds>& from,
+                            const time_point<seconds>& to,
+                            time_zone::offset_schedule* sched) const {
+  const std::size_t timecnt = trans_unix_time_.size();
+  const std::int_fast64_t from_time = ToUnixSeconds(from);
+  const std::int_fast64_t to_time = ToUnixSeconds(to);
+  const std::int_fast64_t last_time = trans_unix_time_.back();
+  std::size_t tr = UpperBound(&trans_unix_time_[0], timecnt, from_time);
+
+  // Find the start of the run in effect at "from". That may be before some
+  // transitions that changed nothing, so we look back past them.
+  std::size_t start = tr;
+  std::uint_fast8_t type_index = default_transition_type_;
+  for (; start != 0; --start) {
+    type_index = trans_type_index_[start - 1];
+    const std::uint_fast8_t prev_type_index =
+        (start == 1) ? default_transition_type_ : trans_type_index_[start - 2];
+    if (!EquivTransitions(prev_type_index, type_index)) break;
+  }
+  std::int_fast64_t unix_start =
+      (start == 0) ? std::numeric_limits<std::int_fast64_t>::min()
+                   : trans_unix_time_[start - 1];
+  std::int_fast64_t unix_times[2];
+  std::uint_fast8_t type_indexes[2];
+  if (tr == timecnt && extended_) {
+    // A rule transition of last year, this year, or even next year (say,
+    // one on January 1st east of UTC) may have followed. As in
+    // RuleLocalTime(), we consider those transitions as offsets from the
+    // start of the year, using years from the 400-year cycle, so that
+    // nothing can overflow when "from" is near time_point::max().
+    const civil_second cs = UnixToCivil(from_time, 0);
+    const std::int_fast64_t secs = SecondsInYear(cs);
+    const std::int_fast64_t jan1_time = from_time - secs;
+    const year_t cycle_year = CycleYear(cs.year());
+    std::int_fast64_t year_start = -kSecsPerYear[IsLeap(cycle_year - 1)];
+    for (year_t y = cycle_year - 1; y != cycle_year + 2; ++y) {
+      std::int_fast64_t offsets[2];
+      RuleOffsets(y, offsets, type_indexes);
+      for (int i = 0; i != 2; ++i) {
+        const std::int_fast64_t offset = year_start + offsets[i];
+        if (offset <= secs && unix_start < jan1_time + offset) {
+          unix_start = jan1_time + offset;
+          type_index = type_indexes[i];
+        }
+      }
+      year_start += kSecsPerYear[IsLeap(y)];
+    }
+  }
+  const TransitionType& tt(transition_types_[type_index]);
+  AppendRun(unix_start, tt.utc_offset, tt.is_dst,
+            &abbreviations_[tt.abbr_index], sched);
+
+  // Then the runs that start in (from, to].
+  for (; tr != timecnt && trans_unix_time_[tr] <= to_time; ++tr) {
+    const TransitionType& next_tt(transition_types_[trans_type_index_[tr]]);
+    AppendRun(trans_unix_time_[tr], next_tt.utc_offset, next_tt.is_dst,
+              &abbreviations_[next_tt.abbr_index], sched);
+  }
+  if (tr != timecnt || !extended_) return;
+  // Start with last year's rules, as a transition at the end of the year
+  // west of UTC happens in the next UTC year, and likewise finish with the
+  // rules of the year after kMaxScheduleYear east of UTC.
+  const std::int_fast64_t after = std::max(from_time, last_time);
+  const std::int_fast64_t end_time = std::min(
+      to_time, (civil_second(kMaxScheduleYear + 1) - civil_second()) - 1);
+  const year_t after_year = UnixToCivil(after, 0).year();
+  for (year_t y = after_year - 1; y <= kMaxScheduleYear + 1; ++y) {
+    RuleTransitions(y, unix_times, type_indexes);
+    for (int i = 0; i != 2; ++i) {
+      if (unix_times[i] <= after) continue;
+      if (unix_times[i] > end_time) return;
+      const TransitionType& next_tt(transition_types_[type_indexes[i]]);
+      AppendRun(unix_times[i], next_tt.utc_offset, next_tt.is_dst,
+                &abbreviations_[next_tt.abbr_index], sched);
+    }
+  }
 }
 
 std::string TimeZoneInfo::Version() const {
@@ -990,44 +1909,56 @@ std::string TimeZoneInfo::Version() const {
 
 std::string TimeZoneInfo::Description() const {
   std::ostringstream oss;
-  oss << "#trans=" << transitions_.size();
+  oss << "#trans=" << trans_unix_time_.size();
   oss << " #types=" << transition_types_.size();
   oss << " spec='" << future_spec_ << "'";
+  if (lazy_years_ != 0) {
+    // Report the transitions we did not generate, and the memory saved.
+    const std::size_t lazy_trans = static_cast<std::size_t>(lazy_years_) * 2;
+    const std::size_t trans_size = sizeof(trans_unix_time_[0]) +
+                                   sizeof(trans_civil_sec_[0]) +
+                                   sizeof(trans_prev_civil_sec_[0]) +
+                                   sizeof(trans_type_index_[0]);
+    oss << " #lazy=" << lazy_trans << " saved=" << lazy_trans * trans_size
+        << "B";
+  }
   return oss.str();
 }
 
 bool TimeZoneInfo::NextTransition(const time_point<seconds>& tp,
                                   time_zone::civil_transition* trans) const {
-  if (transitions_.empty()) return false;
-  const Transition* begin = &transitions_[0];
-  const Transition* end = begin + transitions_.size();
-  if (begin->unix_time <= -(1LL << 59)) {
+  if (trans_unix_time_.empty()) return false;
+  std::size_t begin = 0;
+  const std::size_t end = trans_unix_time_.size();
+  if (trans_unix_time_[begin] <= -(1LL << 59)) {
     // Do not report the BIG_BANG found in some zoneinfo data as it is
     // really a sentinel, not a transition.  See pre-2018f tz/zic.c.
     ++begin;
   }
   std::int_fast64_t unix_time = ToUnixSeconds(tp);
-  const Transition target = {unix_time, 0, civil_second(), civil_second()};
-  const Transition* tr = std::upper_bound(begin, end, target,
-                                          Transition::ByUnixTime());
+  const std::int_least64_t* times = &trans_unix_time_[0];
+  std::size_t tr = begin + UpperBound(times + begin, end - begin, unix_time);
   for (; tr != end; ++tr) {  // skip no-op transitions
     std::uint_fast8_t prev_type_index =
-        (tr == begin) ? default_transition_type_ : tr[-1].type_index;
-    if (!EquivTransitions(prev_type_index, tr[0].type_index)) break;
+        (tr == begin) ? default_transition_type_ : trans_type_index_[tr - 1];
+    if (!EquivTransitions(prev_type_index, trans_type_index_[tr])) break;
+  }
+  // When tr == end we return false, ignoring future_spec_, unless we
+  // are extending lazily and have yet to reach the final generated year.
+  if (tr == end) {
+    return lazy_years_ != 0 && NextRuleTransition(unix_time, trans);
   }
-  // When tr == end we return false, ignoring future_spec_.
-  if (tr == end) return false;
-  trans->from = tr->prev_civil_sec + 1;
-  trans->to = tr->civil_sec;
+  trans->from = civil_second() + (trans_prev_civil_sec_[tr] + 1);
+  trans->to = civil_second() + trans_civil_sec_[tr];
   return true;
 }
 
 bool TimeZoneInfo::PrevTransition(const time_point<seconds>& tp,
                                   time_zone::civil_transition* trans) const {
-  if (transitions_.empty()) return false;
-  const Transition* begin = &transitions_[0];
-  const Transition* end = begin + transitions_.size();
-  if (begin->unix_time <= -(1LL << 59)) {
+  if (trans_unix_time_.empty()) return false;
+  std::size_t begin = 0;
+  std::size_t end = trans_unix_time_.size();
+  if (trans_unix_time_[begin] <= -(1LL << 59)) {
     // Do not report the BIG_BANG found in some zoneinfo data as it is
     // really a sentinel, not a transition.  See pre-2018f tz/zic.c.
     ++begin;
@@ -1035,25 +1966,33 @@ bool TimeZoneInfo::PrevTransition(const time_point<seconds>& tp,
   std::int_fast64_t unix_time = ToUnixSeconds(tp);
   if (FromUnixSeconds(unix_time) != tp) {
     if (unix_time == std::numeric_limits<std::int_fast64_t>::max()) {
+      if (lazy_years_ != 0 && PrevRuleTransition(unix_time, trans)) {
+        return true;
+      }
       if (end == begin) return false;  // Ignore future_spec_.
-      trans->from = (--end)->prev_civil_sec + 1;
-      trans->to = end->civil_sec;
+      --end;
+      trans->from = civil_second() + (trans_prev_civil_sec_[end] + 1);
+      trans->to = civil_second() + trans_civil_sec_[end];
       return true;
     }
     unix_time += 1;  // ceils
   }
-  const Transition target = {unix_time, 0, civil_second(), civil_second()};
-  const Transition* tr = std::lower_bound(begin, end, target,
-                                          Transition::ByUnixTime());
+  if (lazy_years_ != 0 && PrevRuleTransition(unix_time, trans)) {
+    return true;
+  }
+  const std::int_least64_t* times = &trans_unix_time_[0];
+  std::size_t tr = begin + LowerBound(times + begin, end - begin, unix_time);
   for (; tr != begin; --tr) {  // skip no-op transitions
-    std::uint_fast8_t prev_type_index =
-        (tr - 1 == begin) ? default_transition_type_ : tr[-2].type_index;
-    if (!EquivTransitions(prev_type_index, tr[-1].type_index)) break;
+    std::uint_fast8_t prev_type_index = (tr - 1 == begin)
+                                            ? default_transition_type_
+                                            : trans_type_index_[tr - 2];
+    if (!EquivTransitions(prev_type_index, trans_type_index_[tr - 1])) break;
   }
   // When tr == end we return the "last" transition, ignoring future_spec_.
   if (tr == begin) return false;
-  trans->from = (--tr)->prev_civil_sec + 1;
-  trans->to = tr->civil_sec;
+  --tr;
+  trans->from = civil_second() + (trans_prev_civil_sec_[tr] + 1);
+  trans->to = civil_second() + trans_civil_sec_[tr];
   return true;
 }
 
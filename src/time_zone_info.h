@@ -15,7 +15,6 @@
 #ifndef CCTZ_TIME_ZONE_INFO_H_
 #define CCTZ_TIME_ZONE_INFO_H_
 
-#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <string>
@@ -25,29 +24,11 @@
 #include "cctz/time_zone.h"
 #include "cctz/zone_info_source.h"
 #include "time_zone_if.h"
+#include "time_zone_posix.h"
 #include "tzfile.h"
 
 namespace cctz {
 
-// A transition to a new UTC offset.
-struct Transition {
-  std::int_least64_t unix_time;   // the instant of this transition
-  std::uint_least8_t type_index;  // index of the transition type
-  civil_second civil_sec;         // local civil time of transition
-  civil_second prev_civil_sec;    // local civil time one second earlier
-
-  struct ByUnixTime {
-    inline bool operator()(const Transition& lhs, const Transition& rhs) const {
-      return lhs.unix_time < rhs.unix_time;
-    }
-  };
-  struct ByCivilTime {
-    inline bool operator()(const Transition& lhs, const Transition& rhs) const {
-      return lhs.civil_sec < rhs.civil_sec;
-    }
-  };
-};
-
 // The characteristics of a particular transition.
 struct TransitionType {
   std::int_least32_t utc_offset;  // the new prevailing UTC offset
@@ -67,15 +48,38 @@ class TimeZoneInfo : public TimeZoneIf {
   // Loads the zoneinfo for the given name, returning true if successful.
   bool Load(const std::string& name);
 
+  // Appends the compiled form of the loaded zoneinfo, as stored in a zone
+  // bundle (see zone_bundle.h), to *record.
+  void Compile(std::string* record) const;
+
+  // The calling thread's counts of the BreakTime() and MakeTime() calls
+  // that consulted a lookup hint, in any zone, and of those that the hint
+  // satisfied, for benchmarks of the hint hit rate.
+  struct HintStats {
+    std::uint_least64_t checks;
+    std::uint_least64_t hits;
+  };
+  static HintStats ThreadHintStatsTestOnly();
+
   // TimeZoneIf implementations.
   time_zone::absolute_lookup BreakTime(
       const time_point<seconds>& tp) const override;
+  void BreakTimes(const time_point<seconds>* tps, std::size_t n,
+                  time_zone::absolute_lookup* als) const override;
+  time_zone::absolute_lookup BreakTimeSpan(
+      const time_point<seconds>& tp, std::size_t* hint,
+      time_point<seconds>* first, time_point<seconds>* last) const override;
   time_zone::civil_lookup MakeTime(
       const civil_second& cs) const override;
+  void MakeTimes(const civil_second* cs, std::size_t n,
+                 time_zone::civil_lookup* cls) const override;
   bool NextTransition(const time_point<seconds>& tp,
                       time_zone::civil_transition* trans) const override;
   bool PrevTransition(const time_point<seconds>& tp,
                       time_zone::civil_transition* trans) const override;
+  void Schedule(const time_point<seconds>& from,
+                const time_point<seconds>& to,
+                time_zone::offset_schedule* sched) const override;
   std::string Version() const override;
   std::string Description() const override;
 
@@ -100,16 +104,40 @@ class TimeZoneInfo : public TimeZoneIf {
 
   bool ResetToBuiltinUTC(const seconds& offset);
   bool Load(ZoneInfoSource* zip);
+  bool LoadCompiled(ZoneInfoSource* zip);
+  bool ComputeCivilTimes();
 
   // Helpers for BreakTime() and MakeTime().
   time_zone::absolute_lookup LocalTime(std::int_fast64_t unix_time,
                                        const TransitionType& tt) const;
   time_zone::absolute_lookup LocalTime(std::int_fast64_t unix_time,
-                                       const Transition& tr) const;
-  time_zone::civil_lookup TimeLocal(const civil_second& cs,
-                                    year_t c4_shift) const;
-
-  std::vector<Transition> transitions_;  // ordered by unix_time and civil_sec
+                                       std::size_t tr) const;
+  time_zone::civil_lookup MakeTimeAt(const civil_second& cs,
+                                     std::int_fast64_t key,
+                                     std::size_t tr) const;
+
+  // Helpers for the transitions generated by the future rules.
+  void RuleOffsets(year_t year, std::int_fast64_t* offsets,
+                   std::uint_fast8_t* type_indexes) const;
+  void RuleTransitions(year_t year, std::int_fast64_t* unix_times,
+                       std::uint_fast8_t* type_indexes) const;
+  time_zone::absolute_lookup RuleLocalTime(std::int_fast64_t unix_time) const;
+  time_zone::civil_lookup RuleTimeLocal(const civil_second& cs) const;
+  bool NextRuleTransition(std::int_fast64_t unix_time,
+                          time_zone::civil_transition* trans) const;
+  bool PrevRuleTransition(std::int_fast64_t unix_time,
+                          time_zone::civil_transition* trans) const;
+  void RuleTransition(std::int_fast64_t unix_time, std::uint_fast8_t type_index,
+                      time_zone::civil_transition* trans) const;
+
+  // The transitions to new UTC offsets, ordered by both time and local civil
+  // time, and held as a structure of arrays so that searches only touch the
+  // keys they compare. Civil times are stored as seconds since civil_second(),
+  // so they compare just like the civil_seconds they represent.
+  std::vector<std::int_least64_t> trans_unix_time_;       // transition instant
+  std::vector<std::int_least64_t> trans_civil_sec_;       // local civil time
+  std::vector<std::int_least64_t> trans_prev_civil_sec_;  // one second earlier
+  std::vector<std::uint_least8_t> trans_type_index_;      // transition type
   std::vector<TransitionType> transition_types_;  // distinct transition types
   std::uint_fast8_t default_transition_type_;  // for before first transition
   std::string abbreviations_;  // all the NUL-terminated abbreviations
@@ -119,11 +147,19 @@ class TimeZoneInfo : public TimeZoneIf {
   bool extended_;            // future_spec_ was used to generate transitions
   year_t last_year_;         // the final year of the generated transitions
 
-  // We remember the transitions found during the last BreakTime() and
-  // MakeTime() calls. If the next request is for the same transition we
-  // will avoid re-searching.
-  mutable std::atomic<std::size_t> local_time_hint_ = {};  // BreakTime() hint
-  mutable std::atomic<std::size_t> time_local_hint_ = {};  // MakeTime() hint
+  // When extended_, the parsed future_spec_ and its transition types, from
+  // which lookups after the last generated transition are computed. When
+  // extending lazily, the transitions for the final lazy_years_ of the 400
+  // are not generated at all (see CCTZ_EXTENSION_YEARS).
+  PosixTimeZone future_posix_;
+  std::uint_least8_t future_std_type_;
+  std::uint_least8_t future_dst_type_;
+  year_t lazy_years_ = 0;
+
+  // The transitions found during the last BreakTime() and MakeTime() calls
+  // are remembered per thread (see ThreadHints() in time_zone_info.cc), so
+  // that threads working in different eras of a zone do not disturb each
+  // other.
 };
 
 }  // namespace cctz
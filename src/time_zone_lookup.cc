@@ -33,6 +33,8 @@
 #include <zircon/types.h>
 #endif
 
+#include <cstddef>
+#include <cstdint>
 #include <cstdlib>
 #include <cstring>
 #include <string>
@@ -80,10 +82,61 @@ time_zone::absolute_lookup time_zone::lookup(
   return effective_impl().BreakTime(tp);
 }
 
+void time_zone::lookup(const time_point<seconds>* tps, std::size_t n,
+                       absolute_lookup* out) const {
+  effective_impl().BreakTimes(tps, n, out);
+}
+
+time_zone::cursor::cursor(const time_zone& tz)
+    : impl_(&tz.effective_impl()),
+      hint_(0),
+      first_(time_point<seconds>::max()),  // an empty span
+      last_(time_point<seconds>::min()),
+      base_(),
+      al_() {}
+
+void time_zone::cursor::seek(const time_point<seconds>& tp) {
+  al_ = impl_->BreakTimeSpan(tp, &hint_, &first_, &last_);
+  base_ = tp;
+
+  // Limit the span so that the civil-time arithmetic in lookup() is over
+  // a modest number of seconds (and cannot overflow).
+  const seconds reach(std::int_fast64_t{1} << 31);
+  if (tp > time_point<seconds>::min() + reach && first_ < tp - reach) {
+    first_ = tp - reach;
+  }
+  if (tp < time_point<seconds>::max() - reach && last_ > tp + reach) {
+    last_ = tp + reach;
+  }
+}
+
 time_zone::civil_lookup time_zone::lookup(const civil_second& cs) const {
   return effective_impl().MakeTime(cs);
 }
 
+std::size_t time_zone::lookup(const civil_second* cs, std::size_t n,
+                              civil_lookup* out,
+                              std::uint_least8_t* kinds) const {
+  effective_impl().MakeTimes(cs, n, out);
+  std::size_t anomalies = 0;
+  if (kinds != nullptr) {
+    for (std::size_t i = 0; i != n; ++i) {
+      kinds[i] = static_cast<std::uint_least8_t>(out[i].kind);
+      anomalies += (out[i].kind != civil_lookup::UNIQUE);
+    }
+  } else {
+    for (std::size_t i = 0; i != n; ++i) {
+      anomalies += (out[i].kind != civil_lookup::UNIQUE);
+    }
+  }
+  return anomalies;
+}
+
+time_zone::offset_schedule time_zone::schedule(
+    const time_point<seconds>& from, const time_point<seconds>& to) const {
+  return effective_impl().Schedule(from, to);
+}
+
 bool time_zone::next_transition(const time_point<seconds>& tp,
                                 civil_transition* trans) const {
   return effective_impl().NextTransition(tp, trans);
@@ -14,11 +14,17 @@
 
 #include "cctz/time_zone.h"
 
+#include <algorithm>
 #include <chrono>
 #include <cstddef>
+#include <cstdint>
+#include <cstdio>
 #include <cstdlib>
+#include <fstream>
 #include <future>
+#include <iterator>
 #include <limits>
+#include <random>
 #include <string>
 #include <thread>
 #include <vector>
@@ -28,6 +34,7 @@
 
 #include "cctz/civil_time.h"
 #include "gtest/gtest.h"
+#include "time_zone_search.h"
 
 namespace chrono = std::chrono;
 
@@ -643,6 +650,14 @@ time_zone LoadZone(const std::string& name) {
   return tz;
 }
 
+// Helpers to convert between time points and seconds since the epoch.
+std::int_fast64_t ToUnixSeconds(const time_point<cctz::seconds>& tp) {
+  return tp.time_since_epoch().count();
+}
+time_point<cctz::seconds> FromUnixSeconds(std::int_fast64_t t) {
+  return time_point<cctz::seconds>() + cctz::seconds(t);
+}
+
 // This helper is a macro so that failed expectations show up with the
 // correct line numbers.
 #define ExpectTime(tp, tz, y, m, d, hh, mm, ss, off, isdst, zone) \
@@ -720,6 +735,52 @@ TEST(TimeZones, LoadZonesConcurrently) {
   EXPECT_LE(failures.size(), max_failures) << testing::PrintToString(failures);
 }
 
+TEST(TimeZones, LookupConcurrently) {
+  const time_zone tz = LoadZone("America/Los_Angeles");
+
+  // Each thread converts hourly instants from its own era, and their civil
+  // times back again, so that the threads' lookup hints differ, checking
+  // the results against those computed here.
+  const std::size_t n_threads = 8;
+  const std::size_t n_instants = 24 * 366;
+  std::vector<std::vector<time_point<seconds>>> tps(n_threads);
+  std::vector<std::vector<time_zone::absolute_lookup>> als(n_threads);
+  std::vector<std::vector<time_zone::civil_lookup>> cls(n_threads);
+  for (std::size_t t = 0; t != n_threads; ++t) {
+    auto tp = convert(civil_second(1970 + 9 * t, 1, 1), tz);
+    for (std::size_t i = 0; i != n_instants; ++i) {
+      tps[t].push_back(tp);
+      als[t].push_back(tz.lookup(tp));
+      cls[t].push_back(tz.lookup(als[t].back().cs));
+      tp += chrono::hours(1);
+    }
+  }
+
+  auto lookups = [&](std::size_t t, std::size_t* mismatches) {
+    for (int pass = 0; pass != 8; ++pass) {
+      for (std::size_t i = 0; i != n_instants; ++i) {
+        const time_zone::absolute_lookup al = tz.lookup(tps[t][i]);
+        const time_zone::civil_lookup cl = tz.lookup(al.cs);
+        if (al.cs != als[t][i].cs || al.offset != als[t][i].offset ||
+            cl.kind != cls[t][i].kind || cl.pre != cls[t][i].pre ||
+            cl.trans != cls[t][i].trans || cl.post != cls[t][i].post) {
+          ++*mismatches;
+        }
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  std::vector<std::size_t> mismatches(n_threads);
+  for (std::size_t t = 0; t != n_threads; ++t) {
+    threads.emplace_back(lookups, t, &mismatches[t]);
+  }
+  for (std::size_t t = 0; t != n_threads; ++t) {
+    threads[t].join();
+    EXPECT_EQ(0, mismatches[t]) << "thread " << t;
+  }
+}
+
 TEST(TimeZone, UTC) {
   const time_zone utc = utc_time_zone();
 
@@ -771,6 +832,42 @@ TEST(TimeZone, Failures) {
             convert(civil_second(1970, 1, 1, 0, 0, 0), tz));  // UTC
 }
 
+TEST(TimeZone, LoadFileSizes) {
+  // Zoneinfo files of 64KiB or more are memory mapped, while smaller ones
+  // are read whole, so load copies of a zone on either side of that size.
+  // The larger copy is padded after the data, which the loader ignores.
+  const char* tzdir = std::getenv("TZDIR");
+  std::ifstream in(std::string(tzdir ? tzdir : "/usr/share/zoneinfo") +
+                       "/America/New_York",
+                   std::ios::binary);
+  const std::string data((std::istreambuf_iterator<char>(in)),
+                         std::istreambuf_iterator<char>());
+  if (data.compare(0, 4, "TZif") != 0) return;  // no zoneinfo files
+  const time_zone nyc = LoadZone("America/New_York");
+  for (const std::size_t size : {data.size(), std::size_t{96 * 1024}}) {
+    ASSERT_LE(data.size(), size);
+    const std::string path =
+        testing::TempDir() + "cctz_zoneinfo_" + std::to_string(size);
+    {
+      std::ofstream out(path, std::ios::binary | std::ios::trunc);
+      out << data << std::string(size - data.size(), '\0');
+    }
+    time_zone tz;
+    EXPECT_TRUE(load_time_zone("file:" + path, &tz)) << size;
+    std::remove(path.c_str());
+    // 1900-01-01 to 2100-01-01, by a week and an hour.
+    for (std::int_fast64_t t = -2208988800; t < 4102444800;
+         t += 7 * 24 * 3600 + 3600) {
+      const auto tp = FromUnixSeconds(t);
+      const time_zone::absolute_lookup want = nyc.lookup(tp);
+      const time_zone::absolute_lookup got = tz.lookup(tp);
+      EXPECT_EQ(want.cs, got.cs) << size;
+      EXPECT_EQ(want.offset, got.offset) << size;
+      EXPECT_EQ(want.is_dst, got.is_dst) << size;
+    }
+  }
+}
+
 TEST(TimeZone, Equality) {
   const time_zone a;
   const time_zone b;
@@ -880,6 +977,33 @@ TEST(TimeZoneImpl, LocalTimeInFixed) {
   EXPECT_EQ(weekday::wednesday, get_weekday(convert(tp, tz)));
 }
 
+TEST(TimeZoneImpl, FixedArithmetic) {
+  // Fixed-offset conversions are computed directly, so check them against
+  // civil-time arithmetic, over a wide range of times.
+  std::mt19937 urbg(42);  // a UniformRandomBitGenerator with fixed seed
+  std::uniform_int_distribution<std::int_fast64_t> dist(
+      std::numeric_limits<std::int_fast64_t>::min(),
+      std::numeric_limits<std::int_fast64_t>::max());
+  std::vector<std::int_fast64_t> times = {
+      std::numeric_limits<std::int_fast64_t>::min(), -86401, -86400, -1, 0,
+      1, 86399, 86400, 951782400,  // 2000-02-29
+      std::numeric_limits<std::int_fast64_t>::max()};
+  for (int i = 0; i != 10000; ++i) times.push_back(dist(urbg) >> (i % 40));
+  for (const int offset : {0, 1, -1, 5 * 3600 + 30 * 60, -(12 * 3600 + 2074),
+                           24 * 3600, -24 * 3600}) {
+    const time_zone tz = fixed_time_zone(cctz::seconds(offset));
+    for (const std::int_fast64_t t : times) {
+      const time_zone::absolute_lookup al = tz.lookup(FromUnixSeconds(t));
+      EXPECT_EQ((civil_second() + t) + offset, al.cs) << t << " " << offset;
+      EXPECT_EQ(offset, al.offset);
+      if (t != std::numeric_limits<std::int_fast64_t>::min() &&
+          t != std::numeric_limits<std::int_fast64_t>::max()) {
+        EXPECT_EQ(FromUnixSeconds(t), tz.lookup(al.cs).pre) << t;
+      }
+    }
+  }
+}
+
 TEST(BreakTime, LocalTimeInNewYork) {
   const time_zone tz = LoadZone("America/New_York");
   const auto tp = chrono::system_clock::from_time_t(45);
@@ -901,6 +1025,86 @@ TEST(BreakTime, LocalTimeInSydney) {
   EXPECT_EQ(weekday::thursday, get_weekday(convert(tp, tz)));
 }
 
+TEST(BreakTime, Batch) {
+  // Every 9.5 days from 1880 until 2140, plus some extreme values.
+  std::vector<time_point<cctz::seconds>> tps;
+  tps.push_back(time_point<cctz::seconds>::min());
+  for (auto tp = convert(civil_second(1880, 1, 1, 0, 0, 0), utc_time_zone());
+       tp < convert(civil_second(2140, 1, 1, 0, 0, 0), utc_time_zone());
+       tp += chrono::hours(9 * 24 + 12)) {
+    tps.push_back(tp);
+  }
+  tps.push_back(time_point<cctz::seconds>::max());
+
+  for (const char* name : {"UTC", "America/New_York", "Australia/Lord_Howe",
+                           "Europe/London", "Asia/Kathmandu", "libc:UTC"}) {
+    SCOPED_TRACE(testing::Message() << "In " << name);
+    const time_zone tz = LoadZone(name);
+    for (int order = 0; order != 3; ++order) {
+      if (order == 1) std::reverse(tps.begin(), tps.end());
+      if (order == 2) std::shuffle(tps.begin(), tps.end(), std::mt19937(42));
+      std::vector<time_zone::absolute_lookup> als(tps.size());
+      tz.lookup(tps.data(), tps.size(), als.data());
+      for (std::size_t i = 0; i != tps.size(); ++i) {
+        const time_zone::absolute_lookup al = tz.lookup(tps[i]);
+        EXPECT_EQ(al.cs, als[i].cs);
+        EXPECT_EQ(al.offset, als[i].offset);
+        EXPECT_EQ(al.is_dst, als[i].is_dst);
+        EXPECT_STREQ(al.abbr, als[i].abbr);
+      }
+    }
+  }
+}
+
+TEST(BreakTime, Cursor) {
+  for (const char* name : {"UTC", "America/New_York", "Australia/Lord_Howe",
+                           "Europe/London", "Asia/Kathmandu", "libc:UTC"}) {
+    SCOPED_TRACE(testing::Message() << "In " << name);
+    const time_zone tz = LoadZone(name);
+
+    // Every 9.5 days from 1880 until 2140, plus the instants on either
+    // side of each transition in that range, plus some extreme values.
+    const auto begin = convert(civil_second(1880, 1, 1, 0, 0, 0), tz);
+    const auto end = convert(civil_second(2140, 1, 1, 0, 0, 0), tz);
+    std::vector<time_point<cctz::seconds>> tps;
+    tps.push_back(time_point<cctz::seconds>::min());
+    for (auto tp = begin; tp < end; tp += chrono::hours(9 * 24 + 12)) {
+      tps.push_back(tp);
+    }
+    time_zone::civil_transition trans;
+    for (auto tp = begin; tz.next_transition(tp, &trans) && tp < end;) {
+      tp = tz.lookup(trans.to).trans;
+      tps.push_back(tp - chrono::seconds(1));
+      tps.push_back(tp);
+    }
+    tps.push_back(time_point<cctz::seconds>::max() - chrono::seconds(1));
+    tps.push_back(time_point<cctz::seconds>::max());
+    std::sort(tps.begin(), tps.end());
+
+    for (int order = 0; order != 3; ++order) {
+      if (order == 1) std::reverse(tps.begin(), tps.end());
+      if (order == 2) std::shuffle(tps.begin(), tps.end(), std::mt19937(42));
+      time_zone::cursor cur(tz);
+      for (const auto& tp : tps) {
+        const time_zone::absolute_lookup al = tz.lookup(tp);
+        const time_zone::absolute_lookup cal = cur.lookup(tp);
+        EXPECT_EQ(al.cs, cal.cs);
+        EXPECT_EQ(al.offset, cal.offset);
+        EXPECT_EQ(al.is_dst, cal.is_dst);
+        EXPECT_STREQ(al.abbr, cal.abbr);
+      }
+    }
+  }
+
+  // A cursor in a fixed-offset zone, with sub-second time points.
+  const time_zone tz = fixed_time_zone(chrono::hours(5) + chrono::minutes(30));
+  time_zone::cursor cur(tz);
+  auto tp = chrono::system_clock::from_time_t(0) + chrono::milliseconds(500);
+  for (int i = 0; i != 1000; ++i, tp += chrono::hours(7 * 24 + 1)) {
+    EXPECT_EQ(tz.lookup(tp).cs, cur.lookup(tp).cs);
+  }
+}
+
 TEST(MakeTime, TimePointResolution) {
   const time_zone utc = utc_time_zone();
   const time_point<chrono::nanoseconds> tp_ns =
@@ -945,6 +1149,49 @@ TEST(MakeTime, Normalization) {
   EXPECT_EQ(tp, convert(civil_second(2009, 2, 13, 18, 30, 90), tz));   // second
 }
 
+TEST(MakeTime, Batch) {
+  // Every 9.5 days (plus a few around each DST change in New York) from
+  // 1880 until 2140, plus some extreme values.
+  std::vector<civil_second> css;
+  css.push_back(civil_second::min());
+  for (civil_second cs(1880, 1, 1, 0, 0, 0); cs.year() < 2140;
+       cs += (9 * 24 + 12) * 60 * 60) {
+    css.push_back(cs);
+  }
+  for (year_t y = 2000; y != 2010; ++y) {
+    css.push_back(civil_second(y, 3, 8 + (y % 7), 2, 30, 0));
+    css.push_back(civil_second(y, 11, 1 + (y % 7), 1, 30, 0));
+  }
+  css.push_back(civil_second::max());
+  std::sort(css.begin(), css.end());
+
+  for (const char* name : {"UTC", "America/New_York", "Australia/Lord_Howe",
+                           "Europe/London", "Asia/Kathmandu", "libc:UTC"}) {
+    SCOPED_TRACE(testing::Message() << "In " << name);
+    const time_zone tz = LoadZone(name);
+    for (int order = 0; order != 3; ++order) {
+      if (order == 1) std::reverse(css.begin(), css.end());
+      if (order == 2) std::shuffle(css.begin(), css.end(), std::mt19937(42));
+      std::vector<time_zone::civil_lookup> cls(css.size());
+      std::vector<std::uint_least8_t> kinds(css.size());
+      const std::size_t anomalies =
+          tz.lookup(css.data(), css.size(), cls.data(), kinds.data());
+      EXPECT_EQ(anomalies, tz.lookup(css.data(), css.size(), cls.data()));
+      std::size_t non_unique = 0;
+      for (std::size_t i = 0; i != css.size(); ++i) {
+        const time_zone::civil_lookup cl = tz.lookup(css[i]);
+        EXPECT_EQ(cl.kind, cls[i].kind);
+        EXPECT_EQ(cl.kind, kinds[i]);
+        EXPECT_EQ(cl.pre, cls[i].pre);
+        EXPECT_EQ(cl.trans, cls[i].trans);
+        EXPECT_EQ(cl.post, cls[i].post);
+        if (cl.kind != time_zone::civil_lookup::UNIQUE) ++non_unique;
+      }
+      EXPECT_EQ(non_unique, anomalies);
+    }
+  }
+}
+
 // NOTE: Run this with -ftrapv to detect overflow problems.
 TEST(MakeTime, SysSecondsLimits) {
   const char RFC3339[] =  "%Y-%m-%d%ET%H:%M:%S%Ez";
@@ -1120,6 +1367,125 @@ TEST(MakeTime, LocalTimeLibC) {
 #endif
 }
 
+TEST(MakeTime, FutureRules) {
+  // Beyond its generated transitions, an extended zone evaluates its future
+  // POSIX rules directly. The rules repeat every 400 years, so the results
+  // there must match those 400*k years earlier, which come from the
+  // generated transitions. The rules are evaluated for a year's position
+  // within the cycle, and years 2037 to 2436 cover every position.
+  const std::int_fast64_t kCycleSecs = 146097 * std::int_fast64_t{86400};
+  const char* const kZones[] = {
+      "America/New_York", "Europe/London", "Australia/Sydney",
+      "America/Santiago", "Australia/Lord_Howe",
+  };
+  for (const char* name : kZones) {
+    SCOPED_TRACE(testing::Message() << "In " << name);
+    const time_zone tz = LoadZone(name);
+
+    // The instants and civil times to check: those around each transition
+    // (including the skipped and repeated ones), and around each new year.
+    std::vector<time_point<cctz::seconds>> tps;
+    std::vector<civil_second> css;
+    auto tp = convert(civil_second(2037, 1, 1, 0, 0, 0), utc_time_zone());
+    time_zone::civil_transition trans;
+    while (tz.next_transition(tp, &trans) && trans.from.year() < 2437) {
+      tp = tz.lookup(trans.to).trans;
+      for (const int delta : {-3600, -1800, -1, 0, 1, 1800, 3600}) {
+        tps.push_back(tp + cctz::seconds(delta));
+        css.push_back(trans.from + delta);
+        css.push_back(trans.to + delta);
+      }
+      css.push_back(trans.from + (trans.to - trans.from) / 2);
+    }
+    ASSERT_FALSE(tps.empty());
+    for (year_t y = 2037; y != 2437; ++y) {
+      const civil_second jan1(y, 1, 1, 0, 0, 0);
+      for (const int delta : {-86400, -3600, -1, 0, 1, 3600, 86400}) {
+        tps.push_back(convert(jan1, utc_time_zone()) + cctz::seconds(delta));
+        tps.push_back(tz.lookup(jan1).pre + cctz::seconds(delta));
+        css.push_back(jan1 + delta);
+      }
+    }
+
+    for (const std::int_fast64_t k : {1, 2, 1000, 2500000}) {
+      const year_t dy = 400 * k;
+      const cctz::seconds shift(kCycleSecs * k);
+      for (const auto& t : tps) {
+        const time_zone::absolute_lookup al = tz.lookup(t);
+        const time_zone::absolute_lookup shifted = tz.lookup(t + shift);
+        const civil_second cs = al.cs;
+        EXPECT_EQ(civil_second(cs.year() + dy, cs.month(), cs.day(),
+                               cs.hour(), cs.minute(), cs.second()),
+                  shifted.cs) << cs << " + " << dy << " years";
+        EXPECT_EQ(al.offset, shifted.offset) << cs;
+        EXPECT_EQ(al.is_dst, shifted.is_dst) << cs;
+        EXPECT_STREQ(al.abbr, shifted.abbr) << cs;
+      }
+      for (const civil_second& cs : css) {
+        const time_zone::civil_lookup cl = tz.lookup(cs);
+        const time_zone::civil_lookup shifted =
+            tz.lookup(civil_second(cs.year() + dy, cs.month(), cs.day(),
+                                   cs.hour(), cs.minute(), cs.second()));
+        EXPECT_EQ(cl.kind, shifted.kind) << cs << " + " << dy << " years";
+        EXPECT_EQ(cl.pre + shift, shifted.pre) << cs;
+        EXPECT_EQ(cl.trans + shift, shifted.trans) << cs;
+        EXPECT_EQ(cl.post + shift, shifted.post) << cs;
+      }
+    }
+  }
+}
+
+TEST(TransitionSearch, MatchesStd) {
+  using SearchFn = std::size_t (*)(const std::int_least64_t*, std::size_t,
+                                   std::int_fast64_t);
+  std::vector<SearchFn> upper_bounds = {UpperBound, UpperBoundScalar};
+#if defined(CCTZ_HAVE_X86_SEARCH)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("sse4.2")) upper_bounds.push_back(UpperBoundSSE42);
+  if (__builtin_cpu_supports("avx2")) upper_bounds.push_back(UpperBoundAVX2);
+#endif
+
+  const auto kMin = std::numeric_limits<std::int_least64_t>::min();
+  const auto kMax = std::numeric_limits<std::int_least64_t>::max();
+  for (std::size_t n = 0; n <= 70; ++n) {
+    for (int extremes = 0; extremes != 2; ++extremes) {
+      // Steps of 0, 1 and 3 make for duplicate and adjacent keys.
+      const std::int_least64_t kSteps[] = {0, 1, 3};
+      std::vector<std::int_least64_t> keys;
+      std::int_least64_t k = -100;
+      for (std::size_t i = 0; i != n; ++i) {
+        keys.push_back(k);
+        k += kSteps[i % 3];
+      }
+      if (extremes && n >= 2) {
+        keys.front() = kMin;
+        keys.back() = kMax;
+      }
+      std::vector<std::int_least64_t> probes = {kMin, kMin + 1, -1000,
+                                                1000, kMax - 1, kMax};
+      for (const std::int_least64_t key : keys) {
+        probes.push_back(key);
+        if (key != kMin) probes.push_back(key - 1);
+        if (key != kMax) probes.push_back(key + 1);
+      }
+      const std::int_least64_t* begin = keys.data();
+      const std::int_least64_t* end = begin + n;
+      for (const std::int_least64_t key : probes) {
+        const auto upper =
+            static_cast<std::size_t>(std::upper_bound(begin, end, key) - begin);
+        for (std::size_t f = 0; f != upper_bounds.size(); ++f) {
+          EXPECT_EQ(upper, upper_bounds[f](begin, n, key))
+              << "fn " << f << ", n " << n << ", key " << key;
+        }
+        const auto lower =
+            static_cast<std::size_t>(std::lower_bound(begin, end, key) - begin);
+        EXPECT_EQ(lower, LowerBound(begin, n, key))
+            << "n " << n << ", key " << key;
+      }
+    }
+  }
+}
+
 TEST(NextTransition, UTC) {
   const auto tz = utc_time_zone();
   time_zone::civil_transition trans;
@@ -1222,6 +1588,193 @@ TEST(NextTransition, Scan) {
   }
 }
 
+TEST(Schedule, MatchesLookup) {
+  const struct {
+    civil_second from;
+    civil_second to;
+  } ranges[] = {
+      {civil_second(1800, 1, 1), civil_second(1900, 1, 1)},
+      {civil_second(1970, 1, 1), civil_second(2040, 1, 1)},
+      {civil_second(2036, 6, 1), civil_second(2038, 6, 1)},
+      {civil_second(2400, 1, 1), civil_second(2410, 1, 1)},
+      {civil_second(2021, 1, 1), civil_second(2021, 1, 1)},
+  };
+  for (const char* name : {"UTC", "America/New_York", "Australia/Lord_Howe",
+                           "Europe/London", "Asia/Kathmandu", "Africa/Cairo",
+                           "America/Jamaica", "libc:UTC"}) {
+    SCOPED_TRACE(testing::Message() << "In " << name);
+    const time_zone tz = LoadZone(name);
+    for (const auto& range : ranges) {
+      const auto from = convert(range.from, utc_time_zone());
+      const auto to = convert(range.to, utc_time_zone());
+      const time_zone::offset_schedule sched = tz.schedule(from, to);
+      ASSERT_FALSE(sched.runs.empty());
+      EXPECT_LE(sched.runs.front().unix_start, ToUnixSeconds(from));
+      for (std::size_t i = 0; i != sched.runs.size(); ++i) {
+        const time_zone::offset_run& run = sched.runs[i];
+        ASSERT_LT(run.abbr_id, sched.abbrs.size());
+        if (i != 0) {
+          const time_zone::offset_run& prev = sched.runs[i - 1];
+          EXPECT_LT(prev.unix_start, run.unix_start);
+          EXPECT_LE(run.unix_start, ToUnixSeconds(to));
+          EXPECT_FALSE(prev.utc_offset == run.utc_offset &&
+                       prev.is_dst == run.is_dst &&
+                       prev.abbr_id == run.abbr_id);
+        }
+        // Check the run against lookup() at its start (or "from").
+        const auto tp = FromUnixSeconds(
+            std::max(run.unix_start, ToUnixSeconds(from)));
+        const time_zone::absolute_lookup al = tz.lookup(tp);
+        EXPECT_EQ(al.offset, run.utc_offset);
+        EXPECT_EQ(al.is_dst, run.is_dst);
+        EXPECT_EQ(al.abbr, sched.abbrs[run.abbr_id]);
+        if (run.unix_start != std::numeric_limits<std::int_fast64_t>::min()) {
+          // And the previous second belongs to another run.
+          const time_zone::absolute_lookup prev_al =
+              tz.lookup(FromUnixSeconds(run.unix_start - 1));
+          EXPECT_FALSE(prev_al.offset == run.utc_offset &&
+                       prev_al.is_dst == run.is_dst &&
+                       prev_al.abbr == sched.abbrs[run.abbr_id]);
+        }
+      }
+      // And check a sampling of times within the range.
+      for (auto tp = from; tp <= to; tp += chrono::hours(13 * 24 + 1)) {
+        const std::int_fast64_t t = ToUnixSeconds(tp);
+        auto it = std::upper_bound(
+            sched.runs.begin(), sched.runs.end(), t,
+            [](std::int_fast64_t t, const time_zone::offset_run& run) {
+              return t < run.unix_start;
+            });
+        ASSERT_NE(it, sched.runs.begin());
+        --it;
+        const time_zone::absolute_lookup al = tz.lookup(tp);
+        EXPECT_EQ(al.offset, it->utc_offset);
+        EXPECT_EQ(al.is_dst, it->is_dst);
+        EXPECT_EQ(al.abbr, sched.abbrs[it->abbr_id]);
+      }
+    }
+  }
+}
+
+TEST(Schedule, Unbounded) {
+  const auto min = time_point<cctz::seconds>::min();
+  const auto max = time_point<cctz::seconds>::max();
+  const auto y2020 = convert(civil_second(2020, 1, 1), utc_time_zone());
+
+  // The future rules are followed through the year 9999, and no further.
+  const time_zone nyc = LoadZone("America/New_York");
+  for (const auto from : {min, y2020}) {
+    const time_zone::offset_schedule sched = nyc.schedule(from, max);
+    ASSERT_GE(sched.runs.size(), 2 * (9999 - 2020));
+    const time_zone::offset_run& last = sched.runs.back();
+    EXPECT_EQ(9999, (civil_second() + last.unix_start).year());
+    const time_zone::absolute_lookup al =
+        nyc.lookup(FromUnixSeconds(last.unix_start));
+    EXPECT_EQ(al.offset, last.utc_offset);
+    EXPECT_EQ(al.is_dst, last.is_dst);
+  }
+  const time_zone::offset_schedule far = nyc.schedule(max, max);
+  ASSERT_EQ(1, far.runs.size());
+  EXPECT_EQ(nyc.lookup(max).offset, far.runs[0].utc_offset);
+
+  const time_zone fixed = fixed_time_zone(chrono::hours(5) +
+                                          chrono::minutes(30));
+  for (const auto from : {min, y2020, max}) {
+    const time_zone::offset_schedule sched = fixed.schedule(from, max);
+    ASSERT_EQ(1, sched.runs.size());
+    EXPECT_EQ(std::numeric_limits<std::int_fast64_t>::min(),
+              sched.runs[0].unix_start);
+    EXPECT_EQ(5 * 3600 + 30 * 60, sched.runs[0].utc_offset);
+  }
+}
+
+TEST(Schedule, NewYearRules) {
+  // Zones compiled by "zic -b slim", with rules that change the offset at
+  // the new year, so that some rule transitions happen in the UTC year
+  // before or after the year that names them.
+  const struct {
+    const char* name;
+    std::string data;
+  } zones[] = {
+      // <+03>-3<+04>,0/0,J182/0: +04 from 2000-12-31 21:00 UTC.
+      {"East",
+       std::string(
+           "TZif2\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000"
+           "\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000"
+           "\000\000\000\001\000\000\000\001\000\000\000\000\000\000\000TZif"
+           "2\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000"
+           "\000\000\000\000\000\000\000\000\000\000\000\000\000\000\001\000"
+           "\000\000\001\000\000\000\004\000\000\000\0008m\031P\000\000\0008@"
+           "\001\000+04\000\012<+03>-3<+04>,0/0,J182/0\012",
+           139)},
+      // <-03>3<-02>,J182/0,J365/23: -03 from 2001-01-01 01:00 UTC.
+      {"West",
+       std::string(
+           "TZif2\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000"
+           "\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000"
+           "\000\000\000\001\000\000\000\001\000\000\000\000\000\000\000TZif"
+           "2\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000"
+           "\000\000\000\000\000\000\000\000\000\000\000\000\000\000\001\000"
+           "\000\000\001\000\000\000\004\000\000\000\0009]^\260\000\377\377"
+           "\343\340\001\000-02\000\012<-03>3<-02>,J182/0,J365/23\012",
+           142)},
+  };
+  for (const auto& zone : zones) {
+    SCOPED_TRACE(testing::Message() << "In " << zone.name);
+    const std::string path =
+        testing::TempDir() + "cctz_zoneinfo_" + zone.name;
+    {
+      std::ofstream out(path, std::ios::binary | std::ios::trunc);
+      out << zone.data;
+    }
+    time_zone tz;
+    ASSERT_TRUE(load_time_zone("file:" + path, &tz));
+    std::remove(path.c_str());
+
+    // Schedules from each hour around the new year, checked hourly.
+    for (const year_t year : {2020, 2500, 9999}) {
+      const auto new_year = convert(civil_second(year, 1, 1), utc_time_zone());
+      for (auto from = new_year - chrono::hours(6);
+           from <= new_year + chrono::hours(6); from += chrono::hours(1)) {
+        const auto to = from + chrono::hours(12);
+        const time_zone::offset_schedule sched = tz.schedule(from, to);
+        for (auto tp = from; tp <= to; tp += chrono::hours(1)) {
+          auto it = std::upper_bound(
+              sched.runs.begin(), sched.runs.end(), ToUnixSeconds(tp),
+              [](std::int_fast64_t t, const time_zone::offset_run& run) {
+                return t < run.unix_start;
+              });
+          const std::string when =
+              format("%E4Y-%m-%d %H:%M", tp, utc_time_zone()) + " from " +
+              format("%E4Y-%m-%d %H:%M", from, utc_time_zone());
+          ASSERT_NE(it, sched.runs.begin()) << when;
+          --it;
+          const time_zone::absolute_lookup al = tz.lookup(tp);
+          EXPECT_EQ(al.offset, it->utc_offset) << when;
+          EXPECT_EQ(al.is_dst, it->is_dst) << when;
+        }
+      }
+    }
+
+    // The final run holds through the end of the year 9999.
+    const auto y10k = convert(civil_second(10000, 1, 1), utc_time_zone());
+    const time_zone::offset_schedule last =
+        tz.schedule(y10k - chrono::hours(24), y10k + chrono::hours(24));
+    ASSERT_FALSE(last.runs.empty());
+    EXPECT_GE(ToUnixSeconds(y10k - chrono::hours(24)),
+              last.runs.front().unix_start);
+    EXPECT_EQ(tz.lookup(y10k - cctz::seconds(1)).offset,
+              last.runs.back().utc_offset);
+
+    // The run in effect at the end of time.
+    const auto max = time_point<cctz::seconds>::max();
+    const time_zone::offset_schedule far = tz.schedule(max, max);
+    ASSERT_EQ(1, far.runs.size());
+    EXPECT_LE(far.runs[0].unix_start, ToUnixSeconds(max));
+    EXPECT_EQ(tz.lookup(max).offset, far.runs[0].utc_offset);
+  }
+}
+
 TEST(TimeZoneEdgeCase, AmericaNewYork) {
   const time_zone tz = LoadZone("America/New_York");
 
@@ -0,0 +1,134 @@
+// Copyright 2016 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   https://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+
+#include "time_zone_search.h"
+
+#if defined(CCTZ_HAVE_X86_SEARCH)
+#include <immintrin.h>
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace cctz {
+
+namespace {
+
+using SearchFn = std::size_t (*)(const std::int_least64_t*, std::size_t,
+                                 std::int_fast64_t);
+
+// Narrows the search for the upper bound of key to [*base, *base + n],
+// where n <= limit, and returns that n. The keys before *base are all
+// <= key, and those at or after *base + n are all > key, so the result
+// is *base plus the count of keys in [*base, *base + n) that are <= key.
+// Each step is a conditional move rather than a branch, so the search
+// does not suffer from mispredictions when given unpredictable keys.
+inline std::size_t Narrow(const std::int_least64_t** base, std::size_t n,
+                          std::int_fast64_t key, std::size_t limit) {
+  const std::int_least64_t* b = *base;
+  while (n > limit) {
+    const std::size_t half = n / 2;
+    b = (b[half] <= key) ? b + half : b;
+    n -= half;
+  }
+  *base = b;
+  return n;
+}
+
+}  // namespace
+
+std::size_t UpperBoundScalar(const std::int_least64_t* keys, std::size_t n,
+                             std::int_fast64_t key) {
+  if (n == 0) return 0;
+  const std::int_least64_t* base = keys;
+  Narrow(&base, n, key, 1);
+  return static_cast<std::size_t>(base - keys) + (*base <= key ? 1 : 0);
+}
+
+#if defined(CCTZ_HAVE_X86_SEARCH)
+
+// The vector searches narrow to a block of keys, and then count those in
+// the block that are <= key. The block may start before the narrowed
+// range so that it does not extend beyond the array, which is harmless
+// as the keys before the range are also <= key.
+namespace {
+constexpr std::size_t kBlockSize = 8;
+}  // namespace
+
+__attribute__((target("avx2")))
+std::size_t UpperBoundAVX2(const std::int_least64_t* keys, std::size_t n,
+                           std::int_fast64_t key) {
+  if (n < kBlockSize) return UpperBoundScalar(keys, n, key);
+  const std::int_least64_t* base = keys;
+  Narrow(&base, n, key, kBlockSize);
+  if (base > keys + (n - kBlockSize)) base = keys + (n - kBlockSize);
+  const __m256i k = _mm256_set1_epi64x(key);
+  const __m256i* p = reinterpret_cast<const __m256i*>(base);
+  const __m256i gt0 = _mm256_cmpgt_epi64(_mm256_loadu_si256(p + 0), k);
+  const __m256i gt1 = _mm256_cmpgt_epi64(_mm256_loadu_si256(p + 1), k);
+  const int gt = _mm256_movemask_pd(_mm256_castsi256_pd(gt0)) |
+                 (_mm256_movemask_pd(_mm256_castsi256_pd(gt1)) << 4);
+  return static_cast<std::size_t>(base - keys) + kBlockSize -
+         static_cast<std::size_t>(__builtin_popcount(gt));
+}
+
+__attribute__((target("sse4.2")))
+std::size_t UpperBoundSSE42(const std::int_least64_t* keys, std::size_t n,
+                            std::int_fast64_t key) {
+  if (n < kBlockSize) return UpperBoundScalar(keys, n, key);
+  const std::int_least64_t* base = keys;
+  Narrow(&base, n, key, kBlockSize);
+  if (base > keys + (n - kBlockSize)) base = keys + (n - kBlockSize);
+  const __m128i k = _mm_set1_epi64x(key);
+  const __m128i* p = reinterpret_cast<const __m128i*>(base);
+  int gt = 0;
+  for (int i = 0; i != 4; ++i) {
+    const __m128i gti = _mm_cmpgt_epi64(_mm_loadu_si128(p + i), k);
+    gt |= _mm_movemask_pd(_mm_castsi128_pd(gti)) << (2 * i);
+  }
+  return static_cast<std::size_t>(base - keys) + kBlockSize -
+         static_cast<std::size_t>(__builtin_popcount(gt));
+}
+
+#endif  // CCTZ_HAVE_X86_SEARCH
+
+namespace {
+
+SearchFn ChooseUpperBound() {
+#if defined(CCTZ_HAVE_X86_SEARCH)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) return UpperBoundAVX2;
+  if (__builtin_cpu_supports("sse4.2")) return UpperBoundSSE42;
+#endif
+  return UpperBoundScalar;
+}
+
+}  // namespace
+
+std::size_t UpperBound(const std::int_least64_t* keys, std::size_t n,
+                       std::int_fast64_t key) {
+  static const SearchFn search = ChooseUpperBound();
+  return search(keys, n, key);
+}
+
+std::size_t LowerBound(const std::int_least64_t* keys, std::size_t n,
+                       std::int_fast64_t key) {
+  // The keys are integers, so the first that is not less than key is
+  // the first that is greater than key - 1.
+  if (key == std::numeric_limits<std::int_fast64_t>::min()) return 0;
+  return UpperBound(keys, n, key - 1);
+}
+
+}  // namespace cctz
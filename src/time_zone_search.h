@@ -0,0 +1,55 @@
+// Copyright 2016 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   https://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+
+#ifndef CCTZ_TIME_ZONE_SEARCH_H_
+#define CCTZ_TIME_ZONE_SEARCH_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__x86_64__) && defined(__linux__) && \
+    (defined(__GNUC__) || defined(__clang__))
+#define CCTZ_HAVE_X86_SEARCH 1
+#endif
+
+namespace cctz {
+
+// Searches for a key in the sorted array keys[0, n), returning the index of
+// the first element that is greater than the key, like std::upper_bound(),
+// or of the first element that is not less than the key, like
+// std::lower_bound(). These are used to find the transitions surrounding
+// an instant or a civil time, where the arrays hold up to a few thousand
+// keys. The search is branchless, and on x86-64 its final steps compare
+// a block of keys at once using the widest vector instructions available
+// at runtime.
+std::size_t UpperBound(const std::int_least64_t* keys, std::size_t n,
+                       std::int_fast64_t key);
+std::size_t LowerBound(const std::int_least64_t* keys, std::size_t n,
+                       std::int_fast64_t key);
+
+// The implementations of UpperBound(), one of which it chooses at runtime.
+// They are exposed so that each may be tested, but the vector forms must
+// only be called when __builtin_cpu_supports() the instructions they use.
+std::size_t UpperBoundScalar(const std::int_least64_t* keys, std::size_t n,
+                             std::int_fast64_t key);
+#if defined(CCTZ_HAVE_X86_SEARCH)
+std::size_t UpperBoundSSE42(const std::int_least64_t* keys, std::size_t n,
+                            std::int_fast64_t key);  // "sse4.2"
+std::size_t UpperBoundAVX2(const std::int_least64_t* keys, std::size_t n,
+                           std::int_fast64_t key);  // "avx2"
+#endif
+
+}  // namespace cctz
+
+#endif  // CCTZ_TIME_ZONE_SEARCH_H_
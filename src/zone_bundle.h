@@ -0,0 +1,72 @@
+// Copyright 2016 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   https://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+
+#ifndef CCTZ_ZONE_BUNDLE_H_
+#define CCTZ_ZONE_BUNDLE_H_
+
+// A zone bundle is a single file holding the compiled zoneinfo for many
+// zones, so that they can all be served from one mapping rather than by
+// opening a file per zone (see zone_bundle_tool.cc, which builds them, and
+// the CCTZ_ZONE_BUNDLE environment variable, which names the bundle to use).
+// As with TZif, all multi-byte integers are MSB first.
+//
+// A bundle begins with a zone_bundle_header, which is followed by zonecnt
+// zone_bundle_entry index entries, sorted by name, and then by the data
+// for each zone. The index is similar to that in Android's tzdata file.
+
+namespace cctz {
+
+#define ZONE_BUNDLE_MAGIC "CCTZzb01"
+
+struct zone_bundle_header {
+  char magic[8];          // ZONE_BUNDLE_MAGIC
+  char version[16];       // tzdata version, NUL padded
+  char zonecnt[4];        // number of index entries
+  char index_offset[4];   // from the start of the bundle
+  char data_offset[4];    // from the start of the bundle
+};
+
+struct zone_bundle_entry {
+  char name[40];          // zone name, NUL padded
+  char offset[4];         // from data_offset
+  char length[4];         // of the compiled zoneinfo
+};
+
+// The compiled zoneinfo for a zone is the state of a TimeZoneInfo after
+// its TZif data has been parsed, trimmed, and extended using the future
+// POSIX spec, so none of that work is repeated when it is loaded:
+//
+//   char magic[4];                    // ZONE_RECORD_MAGIC
+//   char timecnt[4];                  // number of transitions
+//   char typecnt[4];                  // number of transition types
+//   char charcnt[4];                  // bytes of abbreviations
+//   char speclen[4];                  // bytes of future POSIX spec
+//   char default_type[1];             // for before the first transition
+//   char extended[1];                 // transitions were extended
+//   char last_year[8];                // final year of extended transitions
+//   char unix_time[8][timecnt];       // transition times
+//   char type_index[1][timecnt];      // transition types
+//   struct {
+//     char utc_offset[4];
+//     char is_dst[1];
+//     char abbr_index[1];
+//   } types[typecnt];
+//   char abbreviations[charcnt];      // NUL-terminated abbreviations
+//   char spec[speclen];               // future POSIX spec
+
+#define ZONE_RECORD_MAGIC "CZif"
+
+}  // namespace cctz
+
+#endif  // CCTZ_ZONE_BUNDLE_H_
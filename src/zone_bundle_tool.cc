@@ -0,0 +1,129 @@
+// Copyright 2016 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   https://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+
+// A command-line tool for building a zone bundle (see zone_bundle.h) from
+// the zoneinfo files in ${TZDIR}. For example:
+//
+//   cd ${TZDIR} && find * -type f | zone_bundle_tool zones.bundle
+//
+// Names that do not load as zoneinfo (like "zone1970.tab") are skipped.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "time_zone_info.h"
+#include "zone_bundle.h"
+
+namespace {
+
+std::string Basename(const std::string& p) {
+  auto last_slash = p.find_last_of('/');
+  return last_slash == std::string::npos ? p : p.substr(last_slash + 1);
+}
+
+void Encode32(std::uint_fast32_t v, char* cp) {
+  for (int i = (32 / 8); i-- != 0;) *cp++ = static_cast<char>(v >> (8 * i));
+}
+
+}  // namespace
+
+int main(int argc, const char** argv) {
+  const char* argv0 = (argc > 0) ? (argc--, *argv++) : (argc = 0, "");
+  const std::string prog = Basename(argv0);
+
+  std::string version;
+  int optind = 0;
+  for (; optind < argc; ++optind) {
+    const char* opt = argv[optind];
+    if (std::strncmp(opt, "--version=", 10) == 0) {
+      version = opt + 10;
+    } else if (std::strcmp(opt, "--") == 0) {
+      ++optind;
+      break;
+    } else if (*opt == '-') {
+      std::cerr << argv0 << ": unrecognized option '" << opt << "'\n";
+      return 1;
+    } else {
+      break;
+    }
+  }
+  cctz::zone_bundle_header hdr;
+  if (optind == argc || version.size() > sizeof(hdr.version)) {
+    std::cerr << "Usage: " << prog << " [--version=<tzdata-version>]"
+              << " <bundle> [<zone>...]\n";
+    std::cerr << "  Zone names are read from stdin when none are given.\n";
+    return 1;
+  }
+  const std::string bundle_path = argv[optind++];
+
+  std::vector<std::string> names(argv + optind, argv + argc);
+  if (names.empty()) {
+    for (std::string name; std::getline(std::cin, name);) {
+      if (!name.empty()) names.push_back(name);
+    }
+  }
+  std::sort(names.begin(), names.end());
+  names.erase(std::unique(names.begin(), names.end()), names.end());
+
+  // Compile each zone, building the index as we go.
+  std::vector<cctz::zone_bundle_entry> index;
+  std::string data;
+  for (const std::string& name : names) {
+    cctz::zone_bundle_entry entry;
+    if (name.size() >= sizeof(entry.name)) {
+      std::cerr << prog << ": " << name << ": name too long, skipped\n";
+      continue;
+    }
+    cctz::TimeZoneInfo tzi;
+    if (!tzi.Load(name)) {
+      std::cerr << prog << ": " << name << ": not zoneinfo, skipped\n";
+      continue;
+    }
+    const std::size_t offset = data.size();
+    tzi.Compile(&data);
+    std::memset(entry.name, '\0', sizeof(entry.name));
+    std::memcpy(entry.name, name.data(), name.size());
+    Encode32(static_cast<std::uint_fast32_t>(offset), entry.offset);
+    Encode32(static_cast<std::uint_fast32_t>(data.size() - offset),
+             entry.length);
+    index.push_back(entry);
+  }
+
+  std::memcpy(hdr.magic, ZONE_BUNDLE_MAGIC, sizeof(hdr.magic));
+  std::memset(hdr.version, '\0', sizeof(hdr.version));
+  std::memcpy(hdr.version, version.data(), version.size());
+  const std::size_t index_size = sizeof(index[0]) * index.size();
+  Encode32(static_cast<std::uint_fast32_t>(index.size()), hdr.zonecnt);
+  Encode32(sizeof(hdr), hdr.index_offset);
+  Encode32(static_cast<std::uint_fast32_t>(sizeof(hdr) + index_size),
+           hdr.data_offset);
+
+  std::ofstream out(bundle_path, std::ios::binary | std::ios::trunc);
+  out.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+  out.write(reinterpret_cast<const char*>(index.data()),
+            static_cast<std::streamsize>(index_size));
+  out.write(data.data(), static_cast<std::streamsize>(data.size()));
+  out.close();
+  if (!out) {
+    std::cerr << prog << ": " << bundle_path << ": write failed\n";
+    return 1;
+  }
+  return 0;
+}
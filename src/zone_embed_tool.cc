@@ -0,0 +1,108 @@
+// Copyright 2016 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   https://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+
+// A build tool that generates the C++ source for the zoneinfo embedded in
+// the zone_info_embedded library (see zone_info_embedded.h). It is given
+// the zoneinfo root directory and the files below it to embed, and each
+// file is named by its path relative to that root. Files that are not
+// TZif (like "zone1970.tab") are ignored.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+std::string Basename(const std::string& p) {
+  auto last_slash = p.find_last_of('/');
+  return last_slash == std::string::npos ? p : p.substr(last_slash + 1);
+}
+
+}  // namespace
+
+int main(int argc, const char** argv) {
+  const char* argv0 = (argc > 0) ? (argc--, *argv++) : (argc = 0, "");
+  const std::string prog = Basename(argv0);
+  if (argc < 2) {
+    std::cerr << "Usage: " << prog << " <output.cc> <zoneinfo-root>"
+              << " <zoneinfo-file>...\n";
+    return 1;
+  }
+  const std::string output = argv[0];
+  std::string root = argv[1];
+  if (!root.empty() && root.back() != '/') root += '/';
+
+  // Read every TZif file, keyed by zone name.
+  std::vector<std::pair<std::string, std::string>> zones;
+  for (int i = 2; i < argc; ++i) {
+    const std::string path = argv[i];
+    if (path.compare(0, root.size(), root) != 0) {
+      std::cerr << prog << ": " << path << ": not below " << root << "\n";
+      return 1;
+    }
+    std::ifstream in(path, std::ios::binary);
+    std::string data((std::istreambuf_iterator<char>(in)),
+                     std::istreambuf_iterator<char>());
+    if (!in.eof() && !in) {
+      std::cerr << prog << ": " << path << ": read failed\n";
+      return 1;
+    }
+    if (data.compare(0, 4, "TZif") != 0) continue;
+    zones.emplace_back(path.substr(root.size()), std::move(data));
+  }
+  if (zones.empty()) {
+    std::cerr << prog << ": no zoneinfo files found\n";
+    return 1;
+  }
+  std::sort(zones.begin(), zones.end());  // for binary search by name
+
+  std::ofstream out(output, std::ios::trunc);
+  out << "// Generated by " << prog << ". DO NOT EDIT.\n\n"
+      << "#include \"src/zone_info_embedded.h\"\n\n"
+      << "namespace cctz {\n\nnamespace {\n";
+  char buf[16];
+  for (std::size_t z = 0; z != zones.size(); ++z) {
+    const std::string& data = zones[z].second;
+    out << "\n// " << zones[z].first << "\n"
+        << "constexpr char kZone" << z << "[" << data.size() << "] = {";
+    for (std::size_t i = 0; i != data.size(); ++i) {
+      if (i % 12 == 0) out << "\n   ";
+      std::snprintf(buf, sizeof(buf), " '\\x%02x',",
+                    static_cast<unsigned char>(data[i]));
+      out << buf;
+    }
+    out << "\n};\n";
+  }
+  out << "\n}  // namespace\n\n"
+      << "const EmbeddedZoneInfo kEmbeddedZoneInfo[] = {\n";
+  for (std::size_t z = 0; z != zones.size(); ++z) {
+    out << "    {\"" << zones[z].first << "\", kZone" << z << ", sizeof(kZone"
+        << z << ")},\n";
+  }
+  out << "};\n\n"
+      << "const std::size_t kEmbeddedZoneInfoCount = " << zones.size()
+      << ";\n\n}  // namespace cctz\n";
+  out.close();
+  if (!out) {
+    std::cerr << prog << ": " << output << ": write failed\n";
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,61 @@
+// Copyright 2016 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   https://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+
+#include "zone_info_embedded.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "cctz/zone_info_source.h"
+#include "zone_info_memory.h"
+
+namespace cctz_extension {
+
+namespace {
+
+// Serves the embedded zones, deferring to the fallback factory for others.
+// The embedded data is decoded in place (see MemoryZoneInfoSource).
+std::unique_ptr<cctz::ZoneInfoSource> EmbeddedFactory(
+    const std::string& name,
+    const std::function<std::unique_ptr<cctz::ZoneInfoSource>(
+        const std::string& name)>& fallback_factory) {
+  // Use of the "file:" prefix is intended for testing purposes only.
+  const std::size_t pos = (name.compare(0, 5, "file:") == 0) ? 5 : 0;
+  const char* key = name.c_str() + pos;
+
+  const cctz::EmbeddedZoneInfo* const begin = cctz::kEmbeddedZoneInfo;
+  const cctz::EmbeddedZoneInfo* const end =
+      begin + cctz::kEmbeddedZoneInfoCount;
+  const cctz::EmbeddedZoneInfo* zone = std::lower_bound(
+      begin, end, key, [](const cctz::EmbeddedZoneInfo& z, const char* k) {
+        return strcmp(z.name, k) < 0;
+      });
+  if (zone != end && strcmp(zone->name, key) == 0) {
+    return std::unique_ptr<cctz::ZoneInfoSource>(
+        new cctz::MemoryZoneInfoSource(zone->data, zone->size));
+  }
+  return fallback_factory(name);
+}
+
+}  // namespace
+
+// A "strong" definition for cctz_extension::zone_info_source_factory,
+// which overrides the "weak" default (see zone_info_source.cc).
+ZoneInfoSourceFactory zone_info_source_factory = EmbeddedFactory;
+
+}  // namespace cctz_extension
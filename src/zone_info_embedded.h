@@ -0,0 +1,38 @@
+// Copyright 2016 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   https://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+
+#ifndef CCTZ_ZONE_INFO_EMBEDDED_H_
+#define CCTZ_ZONE_INFO_EMBEDDED_H_
+
+#include <cstddef>
+
+namespace cctz {
+
+// The TZif data for a zone that is compiled into the program. Linking
+// the zone_info_embedded library, which provides a definition of
+// cctz_extension::zone_info_source_factory that serves these zones,
+// allows them to be loaded without any filesystem access.
+struct EmbeddedZoneInfo {
+  const char* name;
+  const char* data;
+  std::size_t size;
+};
+
+// The embedded zones, ordered by name (see zone_embed_tool.cc).
+extern const EmbeddedZoneInfo kEmbeddedZoneInfo[];
+extern const std::size_t kEmbeddedZoneInfoCount;
+
+}  // namespace cctz
+
+#endif  // CCTZ_ZONE_INFO_EMBEDDED_H_
@@ -0,0 +1,70 @@
+// Copyright 2016 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   https://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+
+#ifndef CCTZ_ZONE_INFO_MEMORY_H_
+#define CCTZ_ZONE_INFO_MEMORY_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+#include "cctz/zone_info_source.h"
+
+namespace cctz {
+
+// A ZoneInfoSource over zoneinfo data that already resides in memory (say,
+// a memory-mapped file, or data embedded in the program). TimeZoneInfo
+// probes for this class so that it can decode such data in place, rather
+// than reading it into a buffer, which leaves the public ZoneInfoSource
+// interface (and the vtable of any out-of-tree subclass) unchanged.
+class MemoryZoneInfoSource : public ZoneInfoSource {
+ public:
+  // The data must remain valid for the lifetime of the source.
+  MemoryZoneInfoSource(const char* data, std::size_t len);
+  ~MemoryZoneInfoSource() override;
+
+  // Returns zip as a MemoryZoneInfoSource when it is one, or else nullptr.
+  // Live instances register themselves, so this needs no RTTI, which some
+  // users of the library build without.
+  static MemoryZoneInfoSource* From(ZoneInfoSource* zip);
+
+  std::size_t Read(void* ptr, std::size_t size) override {
+    size = std::min(size, static_cast<std::size_t>(end_ - cur_));
+    std::memcpy(ptr, cur_, size);
+    cur_ += size;
+    return size;
+  }
+  int Skip(std::size_t offset) override {
+    cur_ += std::min(offset, static_cast<std::size_t>(end_ - cur_));
+    return 0;
+  }
+
+  // Returns a pointer to the next size bytes, and advances past them, as
+  // if by Read(). Returns nullptr, without consuming any data, when fewer
+  // than size bytes remain.
+  const char* ReadInPlace(std::size_t size) {
+    if (size > static_cast<std::size_t>(end_ - cur_)) return nullptr;
+    const char* bp = cur_;
+    cur_ += size;
+    return bp;
+  }
+
+ private:
+  const char* cur_;
+  const char* const end_;
+};
+
+}  // namespace cctz
+
+#endif  // CCTZ_ZONE_INFO_MEMORY_H_
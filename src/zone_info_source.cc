@@ -14,12 +14,56 @@
 
 #include "cctz/zone_info_source.h"
 
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+#include "zone_info_memory.h"
+
 namespace cctz {
 
 // Defined out-of-line to avoid emitting a weak vtable in all TUs.
 ZoneInfoSource::~ZoneInfoSource() {}
 std::string ZoneInfoSource::Version() const { return std::string(); }
 
+namespace {
+
+// The live MemoryZoneInfoSource objects. There are rarely more than a
+// few, as each only lives while its zone is being loaded.
+std::mutex& MemorySourcesMutex() {
+  static auto* mutex = new std::mutex;  // never destroyed
+  return *mutex;
+}
+std::vector<const MemoryZoneInfoSource*>& MemorySources() {
+  static auto* sources = new std::vector<const MemoryZoneInfoSource*>;
+  return *sources;
+}
+
+}  // namespace
+
+MemoryZoneInfoSource::MemoryZoneInfoSource(const char* data, std::size_t len)
+    : cur_(data), end_(data + len) {
+  std::lock_guard<std::mutex> lock(MemorySourcesMutex());
+  MemorySources().push_back(this);
+}
+
+MemoryZoneInfoSource::~MemoryZoneInfoSource() {
+  std::lock_guard<std::mutex> lock(MemorySourcesMutex());
+  auto& sources = MemorySources();
+  sources.erase(std::find(sources.begin(), sources.end(), this));
+}
+
+MemoryZoneInfoSource* MemoryZoneInfoSource::From(ZoneInfoSource* zip) {
+  std::lock_guard<std::mutex> lock(MemorySourcesMutex());
+  const auto& sources = MemorySources();
+  if (std::find(sources.begin(), sources.end(), zip) == sources.end()) {
+    return nullptr;
+  }
+  // zip was registered by the MemoryZoneInfoSource constructor, so this
+  // downcast is safe.
+  return static_cast<MemoryZoneInfoSource*>(zip);
+}
+
 }  // namespace cctz
 
 namespace cctz_extension {